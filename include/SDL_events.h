@@ -35,6 +35,7 @@
 #include "SDL_mouse.h"
 #include "SDL_joystick.h"
 #include "SDL_quit.h"
+#include "SDL_rwops.h"
 
 #include "begin_code.h"
 /* Set up for C function definitions, even when using C++ */
@@ -64,7 +65,7 @@ typedef enum {
        SDL_JOYBUTTONUP,			/**< Joystick button released */
        SDL_QUIT,			/**< User-requested quit */
        SDL_SYSWMEVENT,			/**< System specific event */
-       SDL_EVENT_RESERVEDA,		/**< Reserved for future use.. */
+       SDL_TOUCHEVENT,			/**< Touch screen contacts changed */
        SDL_EVENT_RESERVEDB,		/**< Reserved for future use.. */
        SDL_VIDEORESIZE,			/**< User resized video mode */
        SDL_VIDEOEXPOSE,			/**< Screen needs to be redrawn */
@@ -109,6 +110,7 @@ typedef enum {
 	                          SDL_EVENTMASK(SDL_JOYBUTTONUP),
 	SDL_VIDEORESIZEMASK	= SDL_EVENTMASK(SDL_VIDEORESIZE),
 	SDL_VIDEOEXPOSEMASK	= SDL_EVENTMASK(SDL_VIDEOEXPOSE),
+	SDL_TOUCHEVENTMASK	= SDL_EVENTMASK(SDL_TOUCHEVENT),
 	SDL_QUITMASK		= SDL_EVENTMASK(SDL_QUIT),
 	SDL_SYSWMEVENTMASK	= SDL_EVENTMASK(SDL_SYSWMEVENT)
 } SDL_EventMask ;
@@ -187,6 +189,29 @@ typedef struct SDL_JoyButtonEvent {
 	Uint8 state;	/**< SDL_PRESSED or SDL_RELEASED */
 } SDL_JoyButtonEvent;
 
+/** A finger on the touch screen */
+typedef struct SDL_TouchContact {
+	Uint8 id;	/**< Stays the same while the finger is down */
+	Uint16 pressure;	/**< 0 to 65535, or 0 if the device can't tell */
+	Sint16 x, y;	/**< The position, in the same range as the mouse */
+} SDL_TouchContact;
+
+/** The most fingers a touch event carries */
+#define SDL_MAXTOUCH	10
+
+/** Touch screen event structure
+ *  Carries all the fingers down after one touch screen frame, and none once
+ *  the last finger is lifted.  This event is ignored by default: while it
+ *  is enabled with SDL_EventState(), fingers are no longer reported as
+ *  mice 0 to SDL_MAXMOUSE-1, unless the SDL_TOUCH_MOUSE environment
+ *  variable is set to 1.
+ */
+typedef struct SDL_TouchEvent {
+	Uint8 type;	/**< SDL_TOUCHEVENT */
+	Uint8 num_contacts;	/**< Number of fingers down, 0 to SDL_MAXTOUCH */
+	SDL_TouchContact *contacts;	/**< Valid until the next 32 touch events are returned */
+} SDL_TouchEvent;
+
 /** The "window resized" event
  *  When you get this event, you are responsible for setting a new video
  *  mode with the new width and height.
@@ -239,6 +264,7 @@ typedef union SDL_Event {
 	SDL_QuitEvent quit;
 	SDL_UserEvent user;
 	SDL_SysWMEvent syswm;
+	SDL_TouchEvent touch;
 } SDL_Event;
 
 
@@ -289,6 +315,13 @@ extern DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event *event);
  */
 extern DECLSPEC int SDLCALL SDL_WaitEvent(SDL_Event *event);
 
+/** Waits until the specified timeout (in milliseconds) for the next available
+ *  event, returning 1, or 0 if there was an error or the timeout elapsed.
+ *  A timeout of -1 waits indefinitely.  If 'event' is not NULL, the next
+ *  event is removed from the queue and stored in that area.
+ */
+extern DECLSPEC int SDLCALL SDL_WaitEventTimeout(SDL_Event *event, int timeout);
+
 /** Add an event to the event queue.
  *  This function returns 0 on success, or -1 if the event queue was full
  *  or there was some other error.
@@ -347,6 +380,73 @@ extern DECLSPEC SDL_EventFilter SDLCALL SDL_GetEventFilter(void);
 */
 extern DECLSPEC Uint8 SDLCALL SDL_EventState(Uint8 type, int state);
 
+/**
+ *  Returns the time, in microseconds, at which the input behind the event
+ *  last returned on this thread by SDL_PollEvent(), SDL_WaitEvent() or
+ *  SDL_PeepEvents() happened.  It is captured where the driver receives the
+ *  input, so the time the event spent queued can be measured.
+ *
+ *  The clock is monotonic on systems that have one, but its origin is
+ *  unspecified: only differences between timestamps are meaningful.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetEventTimestamp(void);
+
+/**
+ *  Starts writing every event returned by SDL_PollEvent(), SDL_WaitEvent()
+ *  or SDL_PeepEvents() with SDL_GETEVENT to 'dst', along with the time it
+ *  was returned and its SDL_GetEventTimestamp() value.  A NULL 'dst' stops
+ *  the recording.  'dst' stays owned by the caller and must be kept open
+ *  until the recording is stopped.
+ *
+ *  SYSWM and user events are not recorded.
+ *
+ *  @return 0, or -1 if the recording couldn't be started.
+ */
+extern DECLSPEC int SDLCALL SDL_RecordEvents(SDL_RWops *dst);
+
+/**
+ *  Replays events recorded with SDL_RecordEvents() from 'src'.  They are
+ *  queued by SDL_PumpEvents() at the pace they were recorded, or, if
+ *  'fast' is non-zero, one batch of events per time the application found
+ *  the queue empty.  Together with the dummy video and audio drivers this
+ *  replays a session as a repeatable benchmark.  A NULL 'src' stops the
+ *  replay.  'src' stays owned by the caller.
+ *
+ *  Replayed events are queued as they were returned: they don't update the
+ *  keyboard and mouse state reported by SDL_GetKeyState() and
+ *  SDL_GetMouseState().
+ *
+ *  @return 0, or -1 if 'src' is not an event recording.
+ */
+extern DECLSPEC int SDLCALL SDL_ReplayEvents(SDL_RWops *src, int fast);
+
+/** Event queue usage, see SDL_GetEventQueueStats() */
+typedef struct SDL_EventQueueStats {
+	Uint32 capacity;	/**< Events the queue can hold right now */
+	Uint32 max_capacity;	/**< Events the queue can grow to hold */
+	Uint32 high_water;	/**< Most events queued at once */
+	Uint32 dropped;		/**< Events lost because the queue was full */
+	Uint32 dropped_motion;	/**< Motion events discarded to make room */
+	Uint32 coalesced;	/**< Motion events merged into unread ones */
+} SDL_EventQueueStats;
+
+/**
+ *  Returns the event queue usage counters.
+ *
+ *  The initial capacity is set with the SDL_EVENT_QUEUE_SIZE environment
+ *  variable and the queue grows on demand up to SDL_EVENT_QUEUE_MAX events.
+ *  When it is full the oldest queued motion event is discarded to make
+ *  room, so key and button transitions are only lost if there is none.
+ *
+ *  With SDL_EVENT_COALESCE_MOTION=1 in the environment a mouse motion event
+ *  is merged into the last unread motion of the same mouse, adding up xrel
+ *  and yrel, unless another kind of event was queued in between.
+ */
+extern DECLSPEC void SDLCALL SDL_GetEventQueueStats(SDL_EventQueueStats *stats);
+
+/** Resets the high-water mark and drop counters of the event queue */
+extern DECLSPEC void SDLCALL SDL_ResetEventQueueStats(void);
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
@@ -204,6 +204,7 @@ typedef struct SDL_VideoInfo {
 #define SDL_YUY2_OVERLAY  0x32595559	/**< Packed mode: Y0+U0+Y1+V0 (1 plane) */
 #define SDL_UYVY_OVERLAY  0x59565955	/**< Packed mode: U0+Y0+V0+Y1 (1 plane) */
 #define SDL_YVYU_OVERLAY  0x55595659	/**< Packed mode: Y0+V0+Y1+U0 (1 plane) */
+#define SDL_NV12_OVERLAY  0x3231564E	/**< Planar mode: Y + U0+V0  (2 planes), GPU only */
 /*@}*/
 
 /** The YUV hardware video overlay */
@@ -418,6 +419,35 @@ extern DECLSPEC void SDLCALL SDL_UpdateRect
  */
 extern DECLSPEC int SDLCALL SDL_Flip(SDL_Surface *screen);
 
+/**
+ * Set how many vertical blanks a screen update waits for: 0 presents
+ * immediately, 1 synchronizes to the display refresh, and -1 selects
+ * adaptive sync, which waits for the refresh unless the previous frame
+ * was late.  This function returns 0 if successful, or -1 if the video
+ * driver or the current video mode doesn't support it.
+ */
+extern DECLSPEC int SDLCALL SDL_SetSwapInterval(int interval);
+
+/** Presentation timing, see SDL_GetPresentStats() */
+typedef struct SDL_PresentStats {
+	Uint32 frames;		/**< Number of frames presented */
+	Uint32 missed;		/**< Estimated number of missed vertical blanks */
+	Uint32 stalls;		/**< Updates that waited for a free frame */
+	Uint32 submit_us;	/**< CPU time spent composing the last frame */
+	Uint32 swap_us;		/**< Time the last buffer swap blocked */
+	Uint32 frame_us;	/**< Time between the last two presents */
+	Uint32 refresh_us;	/**< Estimated display refresh period */
+	int swap_interval;	/**< Swap interval used for the last frame */
+} SDL_PresentStats;
+
+/**
+ * Fill 'stats' with timing statistics of the screen updates since the
+ * video mode was set.  Times are in microseconds.
+ * This function returns 0 if successful, or -1 if the video driver
+ * doesn't keep statistics.
+ */
+extern DECLSPEC int SDLCALL SDL_GetPresentStats(SDL_PresentStats *stats);
+
 /**
  * Set the gamma correction for each of the color channels.
  * The gamma values range (approximately) between 0.1 and 10.0
@@ -585,6 +615,28 @@ extern DECLSPEC void SDLCALL SDL_FreeSurface(SDL_Surface *surface);
 extern DECLSPEC int SDLCALL SDL_LockSurface(SDL_Surface *surface);
 extern DECLSPEC void SDLCALL SDL_UnlockSurface(SDL_Surface *surface);
 
+/** @name Lock hints for SDL_LockSurfaceEx() */
+/*@{*/
+#define SDL_LOCK_READ		0x01	/**< Pixels will be read */
+#define SDL_LOCK_WRITE		0x02	/**< Pixels will be written */
+#define SDL_LOCK_DISCARD	0x04	/**< Old contents of the rect aren't needed, implies SDL_LOCK_WRITE */
+/*@}*/
+
+/**
+ * SDL_LockSurfaceEx() works like SDL_LockSurface(), but tells the driver
+ * how the pixels will be accessed, which lets it skip waiting for the
+ * GPU or refreshing the display when that isn't needed.
+ *
+ * 'flags' is a combination of the SDL_LOCK_* hints, 0 means read and
+ * write.  If 'rect' is not NULL, only that part of the surface will be
+ * accessed; 'surface->pixels' still points at the top left corner of
+ * the surface.  For recursive locks, the hints of the outermost lock
+ * apply and it must be released with SDL_UnlockSurface().
+ *
+ * SDL_LockSurfaceEx() returns 0, or -1 if the surface couldn't be locked.
+ */
+extern DECLSPEC int SDLCALL SDL_LockSurfaceEx(SDL_Surface *surface, Uint32 flags, const SDL_Rect *rect);
+
 /**
  * Load a surface from a seekable SDL data source (memory or file.)
  * If 'freesrc' is non-zero, the source will be closed after being read.
@@ -760,6 +812,33 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
 			(SDL_Surface *src, SDL_Rect *srcrect,
 			 SDL_Surface *dst, SDL_Rect *dstrect);
 
+/** Filtering used by SDL_StretchBlit() */
+typedef enum {
+	SDL_STRETCH_AUTO = 0,	/**< Let the driver pick based on the scale */
+	SDL_STRETCH_NEAREST,
+	SDL_STRETCH_LINEAR
+} SDL_StretchFilter;
+
+/**
+ * This function performs a scaled blit from 'srcrect' of 'src' to
+ * 'dstrect' of 'dst'.  A NULL rectangle means the whole surface.
+ * Rectangles must lie within their surfaces; they are not clipped.
+ *
+ * If both surfaces are in video memory and the driver can accelerate
+ * scaled blits between them, the driver scales the image, honouring
+ * colorkey and alpha like SDL_BlitSurface().  Only the X11 driver uses
+ * 'filter'; other drivers pick their own filtering.
+ * Otherwise the surfaces must have the same format and the software
+ * stretcher is used, which ignores 'filter' and always samples the
+ * nearest pixel, and ignores colorkey and alpha.
+ *
+ * This function returns 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_StretchBlit
+			(SDL_Surface *src, SDL_Rect *srcrect,
+			 SDL_Surface *dst, SDL_Rect *dstrect,
+			 SDL_StretchFilter filter);
+
 /**
  * This function performs a fast fill of the given rectangle with 'color'
  * The given rectangle is clipped to the destination surface clip area
@@ -38,17 +38,116 @@ Uint8 SDL_ProcessEvents[SDL_NUMEVENTS];
 static Uint32 SDL_eventstate = 0;
 
 /* Private data -- event queue */
-#define MAXEVENTS	128
+#define MAXEVENTS	128	/* default size, must be a power of two */
+#define MAXWMMSGS	128	/* SYSWM messages handed out to the application */
+#define MAXTOUCHES	32	/* Touch contact lists handed out */
+
+/*
+ * Producers on any thread append to a bounded lock-free ring: a slot is
+ *  claimed with a compare-and-swap on 'enqueue' and its sequence number
+ *  tells whether it is free at that position or holds a published event.
+ *  Readers move events from the ring into the 'pending' queue under 'lock'
+ *  and serve SDL_PeepEvents() from there, so producers never block unless
+ *  the ring is full.  The pending queue keeps one FIFO lane per event type,
+ *  and a sequence number restores the global order across lanes, so a
+ *  masked get or peek only visits the events it returns.  With SDL_EVENT_COALESCE_MOTION=1 a mouse motion is
+ *  merged into the last unread motion of the same mouse while it moves.
+ *
+ * The ring size is SDL_EVENT_QUEUE_SIZE (rounded up to a power of two),
+ *  and the pending queue may grow up to SDL_EVENT_QUEUE_MAX events.  When
+ *  both are full the oldest unread motion event is discarded to make room;
+ *  only if there is none the new event is dropped.  Key and button
+ *  transitions are never discarded in favour of motion.
+ */
+#if defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define SDL_EVENTQ_ATOMICS	1
+#define SDL_EventQ_CAS(ptr, old, new)	__sync_bool_compare_and_swap(ptr, old, new)
+#define SDL_EventQ_Add(ptr, value)	__sync_fetch_and_add(ptr, value)
+#define SDL_EventQ_Barrier()		__sync_synchronize()
+#else
+/* No atomics, producers are serialized with 'add_lock' instead */
+#define SDL_EventQ_CAS(ptr, old, new)	(*(ptr) == (old) ? (*(ptr) = (new), 1) : 0)
+#define SDL_EventQ_Add(ptr, value)	((*(ptr) += (value)) - (value))
+#define SDL_EventQ_Barrier()
+#endif
+
+/* Events that may be discarded when the queue is full */
+#define SDL_DISCARDABLEMASK	(SDL_EVENTMASK(SDL_MOUSEMOTION)| \
+				 SDL_EVENTMASK(SDL_JOYAXISMOTION)| \
+				 SDL_EVENTMASK(SDL_JOYBALLMOTION))
+
+typedef struct {
+	SDL_Event event;
+	Uint64 timestamp;
+	union {
+		struct SDL_SysWMmsg wmmsg;
+		SDL_TouchContact contacts[SDL_MAXTOUCH];
+	} data;
+} SDL_EventEntry;
+
+typedef struct {
+	volatile Uint32 seq;
+	SDL_EventEntry entry;
+} SDL_EventSlot;
+
+typedef struct {
+	SDL_EventEntry entry;
+	Uint32 seq;
+	int next;			/* in its lane, or in the free list */
+} SDL_EventNode;
+
 static struct {
-	SDL_mutex *lock;
-	int active;
-	int head;
-	int tail;
-	SDL_Event event[MAXEVENTS];
+	SDL_mutex *lock;	/* readers, and producers on a full ring */
+	SDL_mutex *add_lock;	/* producers, without atomics */
+	volatile int active;
+
+	/* The lock-free ring */
+	Uint32 ring_size;
+	volatile Uint32 enqueue;	/* next position to claim */
+	volatile Uint32 dequeue;	/* next position to move to 'pending' */
+	volatile int count;		/* claimed and not moved yet */
+	SDL_EventSlot *ring;
+
+	/* Events moved out of the ring, not read yet */
+	int used;
+	int size;
+	int max_size;
+	SDL_EventNode *pending;
+	int free_node;
+	int lane_head[SDL_NUMEVENTS];
+	int lane_tail[SDL_NUMEVENTS];
+	Uint32 lanes;			/* mask of the lanes not empty */
+	Uint32 seq;			/* given to the next event moved */
+
+	/* Messages of SYSWM events already returned */
 	int wmmsg_next;
-	struct SDL_SysWMmsg wmmsg[MAXEVENTS];
+	struct SDL_SysWMmsg wmmsg[MAXWMMSGS];
+
+	/* Contacts of touch events already returned */
+	int touch_next;
+	SDL_TouchContact touch[MAXTOUCHES][SDL_MAXTOUCH];
+
+	/* Overflow accounting */
+	volatile Uint32 high_water;
+	volatile Uint32 dropped;
+	volatile Uint32 dropped_motion;
+
+	/* Merge consecutive motion of a mouse */
+	int coalesce;
+	Uint32 coalesced;
+	Uint32 last_other;		/* sequence of the last other event */
+	int last_motion[SDL_MAXMOUSE];
 } SDL_EventQ;
 
+/* Private data -- event timestamps, per thread where possible */
+#if defined(__GNUC__) && defined(__linux__)
+#define SDL_EVENT_THREADLOCAL	__thread
+#else
+#define SDL_EVENT_THREADLOCAL
+#endif
+static SDL_EVENT_THREADLOCAL Uint64 source_timestamp = 0;
+static SDL_EVENT_THREADLOCAL Uint64 last_timestamp = 0;
+
 /* Private data -- event locking structure */
 static struct {
 	SDL_mutex *lock;
@@ -63,10 +162,129 @@ static Uint32 event_thread;			/* The event thread id */
 #define SDL_EVENT_WAKEUP_PIPE 1
 #include <unistd.h> /* for pipe(),select() */
 #include <fcntl.h>  /* for fcntl() */
+#include <sys/time.h> /* for gettimeofday() */
+#if HAVE_CLOCK_GETTIME
+#include <time.h>   /* for clock_gettime() */
+#endif
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+#define SDL_EVENT_EPOLL 1
+#include <sys/epoll.h>
+#endif
 
+/* Readable while the queue may have gone from empty to non-empty.
+   With eventfd both ends are the same descriptor. */
 static int wakeup_pipe[2] = { -1, -1 };
+
+static void SDL_WakeupEvents(void)
+{
+	if (wakeup_pipe[1] != -1) {
+#ifdef HAVE_SYS_EVENTFD_H
+		Uint64 one = 1;
+		write(wakeup_pipe[1], &one, sizeof(one));
+#else
+		write(wakeup_pipe[1], "E", 1);
+#endif
+	}
+}
+
+static void SDL_ClearWakeup(void)
+{
+	if (wakeup_pipe[0] != -1) {
+		char buf[64];
+		/* Non-blocking; one read resets an eventfd */
+		while (read(wakeup_pipe[0], buf, sizeof(buf)) == sizeof(buf))
+			;
+	}
+}
 #endif
 
+/* Descriptors of input devices that SDL_WaitEvent() sleeps on, along with
+   the wakeup pipe and the video connection.  They are kept across restarts
+   of the event loop, since joysticks may be opened before the video. */
+#define MAXSOURCES	16
+
+static int event_sources[MAXSOURCES];
+static int num_event_sources = 0;
+static int lost_event_sources = 0;	/* didn't fit, wake up to poll them */
+#ifdef SDL_EVENT_EPOLL
+static int epoll_fd = -1;
+static int epoll_video_fd = -1;
+static int epoll_sources = 0;	/* the event sources are in the set */
+
+static void SDL_WatchSource(int fd)
+{
+	struct epoll_event ev;
+
+	SDL_memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/* Input devices are only drained while their events are enabled, the
+   application may be polling them itself: watching them then would
+   wake up SDL_WaitEvent() over and over on data nobody reads. */
+static void SDL_WatchSources(int watch)
+{
+	struct epoll_event ev;
+	int i;
+
+	for ( i = 0; i < num_event_sources; ++i ) {
+		if ( watch ) {
+			SDL_WatchSource(event_sources[i]);
+		} else {
+			epoll_ctl(epoll_fd, EPOLL_CTL_DEL, event_sources[i], &ev);
+		}
+	}
+	epoll_sources = watch;
+}
+#endif
+
+void SDL_AddEventSource(int fd)
+{
+	int i;
+
+	for ( i = 0; i < num_event_sources; ++i ) {
+		if ( event_sources[i] == fd ) {
+			return;
+		}
+	}
+	if ( num_event_sources == MAXSOURCES ) {
+		++lost_event_sources;
+		return;
+	}
+	event_sources[num_event_sources++] = fd;
+#ifdef SDL_EVENT_EPOLL
+	if ( epoll_fd != -1 && epoll_sources ) {
+		SDL_WatchSource(fd);
+	}
+#endif
+}
+
+void SDL_RemoveEventSource(int fd)
+{
+	int i;
+
+	for ( i = 0; i < num_event_sources; ++i ) {
+		if ( event_sources[i] == fd ) {
+			event_sources[i] = event_sources[--num_event_sources];
+#ifdef SDL_EVENT_EPOLL
+			if ( epoll_fd != -1 && epoll_sources ) {
+				struct epoll_event ev;
+				epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+			}
+#endif
+			return;
+		}
+	}
+	if ( lost_event_sources > 0 ) {
+		--lost_event_sources;
+	}
+}
+
 void SDL_Lock_EventThread(void)
 {
 	if ( SDL_EventThread && (SDL_ThreadID() != event_thread) ) {
@@ -84,6 +302,19 @@ void SDL_Unlock_EventThread(void)
 	}
 }
 
+void SDL_Lock_EventQueue(void)
+{
+	if ( SDL_EventQ.lock ) {
+		SDL_mutexP(SDL_EventQ.lock);
+	}
+}
+void SDL_Unlock_EventQueue(void)
+{
+	if ( SDL_EventQ.lock ) {
+		SDL_mutexV(SDL_EventQ.lock);
+	}
+}
+
 #ifdef __OS2__
 /*
  * We'll increase the priority of GobbleEvents thread, so it will process
@@ -125,6 +356,9 @@ static int SDLCALL SDL_GobbleEvents(void *unused)
 		}
 #endif
 
+		/* Queue recorded events that are due */
+		SDL_PumpReplay();
+
 		/* Give up the CPU for the rest of our timeslice */
 		SDL_EventLock.safe = 1;
 		if ( SDL_timer_running ) {
@@ -165,6 +399,12 @@ static int SDL_StartEventThread(Uint32 flags)
 		return(-1);
 #endif
 	}
+#if !SDL_EVENTQ_ATOMICS
+	SDL_EventQ.add_lock = SDL_CreateMutex();
+	if ( SDL_EventQ.add_lock == NULL ) {
+		return(-1);
+	}
+#endif
 #endif /* !SDL_THREADS_DISABLED */
 	SDL_EventQ.active = 1;
 
@@ -197,10 +437,8 @@ static void SDL_StopEventThread(void)
 	SDL_EventQ.active = 0;
 	if ( SDL_EventThread ) {
 #ifdef SDL_EVENT_WAKEUP_PIPE
-		if (wakeup_pipe[1] != -1) {
-			/* Ensure a possibly blocked event thread is awaken. */
-			write(wakeup_pipe[1], "Q", 1);
-		}
+		/* Ensure a possibly blocked event thread is awaken. */
+		SDL_WakeupEvents();
 #endif
 		SDL_WaitThread(SDL_EventThread, NULL);
 		SDL_EventThread = NULL;
@@ -211,6 +449,10 @@ static void SDL_StopEventThread(void)
 	SDL_DestroyMutex(SDL_EventQ.lock);
 	SDL_EventQ.lock = NULL;
 #endif
+	if ( SDL_EventQ.add_lock ) {
+		SDL_DestroyMutex(SDL_EventQ.add_lock);
+		SDL_EventQ.add_lock = NULL;
+	}
 }
 
 Uint32 SDL_EventThreadID(void)
@@ -232,16 +474,110 @@ void SDL_StopEventLoop(void)
 	SDL_QuitQuit();
 
 	/* Clean out EventQ */
-	SDL_EventQ.head = 0;
-	SDL_EventQ.tail = 0;
+	if ( SDL_EventQ.ring ) {
+		SDL_free(SDL_EventQ.ring);
+		SDL_EventQ.ring = NULL;
+	}
+	if ( SDL_EventQ.pending ) {
+		SDL_free(SDL_EventQ.pending);
+		SDL_EventQ.pending = NULL;
+	}
+	SDL_EventQ.ring_size = 0;
+	SDL_EventQ.enqueue = 0;
+	SDL_EventQ.dequeue = 0;
+	SDL_EventQ.count = 0;
+	SDL_EventQ.used = 0;
+	SDL_EventQ.size = 0;
+	SDL_EventQ.max_size = 0;
+	SDL_EventQ.lanes = 0;
 	SDL_EventQ.wmmsg_next = 0;
+	SDL_EventQ.touch_next = 0;
 
 #ifdef SDL_EVENT_WAKEUP_PIPE
-	close(wakeup_pipe[0]);
-	close(wakeup_pipe[1]);
+	if (wakeup_pipe[0] != -1) {
+		close(wakeup_pipe[0]);
+	}
+	if (wakeup_pipe[1] != -1 && wakeup_pipe[1] != wakeup_pipe[0]) {
+		close(wakeup_pipe[1]);
+	}
 	wakeup_pipe[0] = -1;
 	wakeup_pipe[1] = -1;
 #endif
+#ifdef SDL_EVENT_EPOLL
+	if ( epoll_fd != -1 ) {
+		close(epoll_fd);
+	}
+	epoll_fd = -1;
+	epoll_video_fd = -1;
+	epoll_sources = 0;
+#endif
+}
+
+static int SDL_EventQueueSize(const char *name, int size)
+{
+	const char *env = SDL_getenv(name);
+
+	if ( env && SDL_atoi(env) > 0 ) {
+		size = SDL_atoi(env);
+	}
+	return(size);
+}
+
+/* Put nodes from 'first' on into the free list */
+static void SDL_FreeEventNodes(int first)
+{
+	int i;
+
+	for ( i = first; i < SDL_EventQ.size-1; ++i ) {
+		SDL_EventQ.pending[i].next = i+1;
+	}
+	SDL_EventQ.pending[i].next = SDL_EventQ.free_node;
+	SDL_EventQ.free_node = first;
+}
+
+static int SDL_AllocEventQueue(void)
+{
+	Uint32 i;
+	int size, max_size;
+
+	size = SDL_EventQueueSize("SDL_EVENT_QUEUE_SIZE", MAXEVENTS);
+	max_size = SDL_EventQueueSize("SDL_EVENT_QUEUE_MAX", size);
+	for ( i = 16; (int)i < size && i < 0x10000; i *= 2 )
+		;
+	size = i;
+	for ( ; (int)i < max_size && i < 0x100000; i *= 2 )
+		;
+	max_size = i;
+
+	SDL_EventQ.ring = (SDL_EventSlot *)SDL_malloc(size*sizeof(SDL_EventSlot));
+	SDL_EventQ.pending = (SDL_EventNode *)SDL_malloc(size*sizeof(SDL_EventNode));
+	if ( !SDL_EventQ.ring || !SDL_EventQ.pending ) {
+		SDL_OutOfMemory();
+		return(-1);
+	}
+	for ( i = 0; i < (Uint32)size; ++i ) {
+		SDL_EventQ.ring[i].seq = i;
+	}
+	SDL_EventQ.ring_size = size;
+	SDL_EventQ.size = size;
+	SDL_EventQ.max_size = max_size;
+	SDL_EventQ.free_node = -1;
+	SDL_FreeEventNodes(0);
+	for ( i = 0; i < SDL_NUMEVENTS; ++i ) {
+		SDL_EventQ.lane_head[i] = -1;
+		SDL_EventQ.lane_tail[i] = -1;
+	}
+	SDL_EventQ.seq = 0;
+	SDL_EventQ.high_water = 0;
+	SDL_EventQ.dropped = 0;
+	SDL_EventQ.dropped_motion = 0;
+	SDL_EventQ.coalesce = (SDL_EventQueueSize("SDL_EVENT_COALESCE_MOTION", 0) != 0);
+	SDL_EventQ.coalesced = 0;
+	SDL_EventQ.last_other = SDL_EventQ.seq - 1;
+	for ( i = 0; i < SDL_MAXMOUSE; ++i ) {
+		SDL_EventQ.last_motion[i] = -1;
+	}
+	return(0);
 }
 
 /* This function (and associated calls) may be called more than once */
@@ -254,6 +590,11 @@ int SDL_StartEventLoop(Uint32 flags)
 	SDL_EventQ.lock = NULL;
 	SDL_StopEventLoop();
 
+	/* Allocate the event queue */
+	if ( SDL_AllocEventQueue() < 0 ) {
+		return(-1);
+	}
+
 	/* No filter to start with, process most event types */
 	SDL_EventOK = NULL;
 	SDL_memset(SDL_ProcessEvents,SDL_ENABLE,sizeof(SDL_ProcessEvents));
@@ -262,6 +603,10 @@ int SDL_StartEventLoop(Uint32 flags)
 	SDL_eventstate &= ~(0x00000001 << SDL_SYSWMEVENT);
 	SDL_ProcessEvents[SDL_SYSWMEVENT] = SDL_IGNORE;
 
+	/* Touch screens are reported as mice until asked otherwise */
+	SDL_eventstate &= ~SDL_TOUCHEVENTMASK;
+	SDL_ProcessEvents[SDL_TOUCHEVENT] = SDL_IGNORE;
+
 #if !SDL_JOYSTICK_DISABLED
 	/* Also disable joystick events by default. */
 	SDL_eventstate &= ~SDL_JOYEVENTMASK;
@@ -273,15 +618,32 @@ int SDL_StartEventLoop(Uint32 flags)
 #endif
 
 #ifdef SDL_EVENT_WAKEUP_PIPE
-	retcode = pipe(wakeup_pipe);
-	if (retcode != 0) {
+#ifdef HAVE_SYS_EVENTFD_H
+	wakeup_pipe[0] = eventfd(0, 0);
+	if (wakeup_pipe[0] != -1) {
+		wakeup_pipe[1] = wakeup_pipe[0];
+	} else
+#endif
+	if (pipe(wakeup_pipe) != 0) {
 		return -1;
 	}
+	retcode = 0;
 	retcode += fcntl(wakeup_pipe[0], F_SETFD, FD_CLOEXEC);
 	retcode += fcntl(wakeup_pipe[1], F_SETFD, FD_CLOEXEC);
+	retcode += fcntl(wakeup_pipe[0], F_SETFL, O_NONBLOCK);
+	retcode += fcntl(wakeup_pipe[1], F_SETFL, O_NONBLOCK);
 	if (retcode != 0) {
 		return -1;
 	}
+#ifdef SDL_EVENT_EPOLL
+	/* Not fatal, SDL_WaitEvent() falls back to select() */
+	epoll_fd = epoll_create(MAXSOURCES+2);
+	if ( epoll_fd != -1 ) {
+		/* The event sources are added by SDL_WaitForEvent() */
+		fcntl(epoll_fd, F_SETFD, FD_CLOEXEC);
+		SDL_WatchSource(wakeup_pipe[0]);
+	}
+#endif
 #endif
 
 	/* Initialize event handlers */
@@ -304,70 +666,358 @@ int SDL_StartEventLoop(Uint32 flags)
 }
 
 
-/* Add an event to the event queue -- called with the queue locked */
-static int SDL_AddEvent(SDL_Event *event)
+Uint64 SDL_EventTimestampNow(void)
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((Uint64)now.tv_sec * 1000000 + now.tv_nsec / 1000);
+#elif defined(SDL_EVENT_WAKEUP_PIPE)
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return((Uint64)now.tv_sec * 1000000 + now.tv_usec);
+#else
+	return((Uint64)SDL_GetTicks() * 1000);
+#endif
+}
+
+void SDL_SetEventSourceTime(Uint64 timestamp)
+{
+	source_timestamp = timestamp;
+}
+
+/* Grow the pending queue -- called with the queue locked */
+static int SDL_GrowEvents(void)
+{
+	SDL_EventNode *pending;
+	int size;
+
+	if ( SDL_EventQ.size >= SDL_EventQ.max_size ) {
+		return(0);
+	}
+	size = SDL_EventQ.size * 2;
+	pending = (SDL_EventNode *)SDL_realloc(SDL_EventQ.pending,
+					size*sizeof(SDL_EventNode));
+	if ( pending == NULL ) {
+		/* Stay at this size */
+		SDL_EventQ.max_size = SDL_EventQ.size;
+		return(0);
+	}
+	/* Nodes are linked by index, so they survive the move */
+	SDL_EventQ.pending = pending;
+	size = SDL_EventQ.size;
+	SDL_EventQ.size *= 2;
+	SDL_FreeEventNodes(size);
+	return(1);
+}
+
+static Sint16 SDL_AddRel(Sint16 a, Sint16 b)
 {
-	int tail, added;
+	int rel = (int)a + b;
+
+	if ( rel > 32767 ) {
+		rel = 32767;
+	} else if ( rel < -32768 ) {
+		rel = -32768;
+	}
+	return((Sint16)rel);
+}
 
-	tail = (SDL_EventQ.tail+1)%MAXEVENTS;
-	if ( tail == SDL_EventQ.head ) {
-		/* Overflow, drop event */
-		added = 0;
+/* Merge motion into the last unread motion of the same mouse, if nothing
+   but motion of other mice was queued since -- called with the queue locked */
+static int SDL_CoalesceMotion(const SDL_EventEntry *entry)
+{
+	const SDL_MouseMotionEvent *motion = &entry->event.motion;
+	SDL_EventNode *node;
+	SDL_MouseMotionEvent *last;
+
+	if ( motion->which >= SDL_MAXMOUSE ||
+	     SDL_EventQ.last_motion[motion->which] < 0 ) {
+		return(0);
+	}
+	node = &SDL_EventQ.pending[SDL_EventQ.last_motion[motion->which]];
+	last = &node->entry.event.motion;
+	if ( (int)(node->seq - SDL_EventQ.last_other) < 0 ||
+	     last->state != motion->state ) {
+		return(0);
+	}
+	last->x = motion->x;
+	last->y = motion->y;
+	last->xrel = SDL_AddRel(last->xrel, motion->xrel);
+	last->yrel = SDL_AddRel(last->yrel, motion->yrel);
+	node->entry.timestamp = entry->timestamp;
+	++SDL_EventQ.coalesced;
+	return(1);
+}
+
+/* Append an event to its lane -- called with the queue locked */
+static void SDL_QueueEvent(const SDL_EventEntry *entry)
+{
+	SDL_EventNode *node;
+	int n, type;
+
+	n = SDL_EventQ.free_node;
+	node = &SDL_EventQ.pending[n];
+	SDL_EventQ.free_node = node->next;
+	node->entry = *entry;
+	node->seq = SDL_EventQ.seq++;
+	node->next = -1;
+
+	type = entry->event.type;
+	if ( SDL_EventQ.lane_tail[type] < 0 ) {
+		SDL_EventQ.lane_head[type] = n;
+		SDL_EventQ.lanes |= SDL_EVENTMASK(type);
 	} else {
-		SDL_EventQ.event[SDL_EventQ.tail] = *event;
-		if (event->type == SDL_SYSWMEVENT) {
-			/* Note that it's possible to lose an event */
-			int next = SDL_EventQ.wmmsg_next;
-			SDL_EventQ.wmmsg[next] = *event->syswm.msg;
-		        SDL_EventQ.event[SDL_EventQ.tail].syswm.msg =
-						&SDL_EventQ.wmmsg[next];
-			SDL_EventQ.wmmsg_next = (next+1)%MAXEVENTS;
+		SDL_EventQ.pending[SDL_EventQ.lane_tail[type]].next = n;
+	}
+	SDL_EventQ.lane_tail[type] = n;
+	++SDL_EventQ.used;
+
+	if ( type == SDL_MOUSEMOTION ) {
+		if ( entry->event.motion.which < SDL_MAXMOUSE ) {
+			SDL_EventQ.last_motion[entry->event.motion.which] = n;
 		}
-		SDL_EventQ.tail = tail;
-		added = 1;
+	} else {
+		SDL_EventQ.last_other = node->seq;
 	}
-#ifdef SDL_EVENT_WAKEUP_PIPE
-	if (added && wakeup_pipe[1] != -1) {
-		write(wakeup_pipe[1], "E", 1);
+}
+
+/* Move published events out of the ring -- called with the queue locked */
+static int SDL_MoveEvents(void)
+{
+	SDL_EventSlot *slot;
+	Uint32 pos, depth;
+	int moved;
+
+#if !SDL_EVENTQ_ATOMICS
+	if ( SDL_EventQ.add_lock ) {
+		SDL_mutexP(SDL_EventQ.add_lock);
+	}
+#endif
+	depth = SDL_EventQ.used + SDL_EventQ.count;
+	if ( depth > SDL_EventQ.high_water ) {
+		SDL_EventQ.high_water = depth;
+	}
+	for ( moved = 0; ; ++moved ) {
+		pos = SDL_EventQ.dequeue;
+		slot = &SDL_EventQ.ring[pos & (SDL_EventQ.ring_size-1)];
+		if ( slot->seq != pos + 1 ) {
+			/* Empty, or claimed but not published yet */
+			break;
+		}
+		SDL_EventQ_Barrier();
+
+		if ( SDL_EventQ.coalesce &&
+		     slot->entry.event.type == SDL_MOUSEMOTION &&
+		     SDL_CoalesceMotion(&slot->entry) ) {
+			/* Merged into an unread event */
+		} else {
+			if ( SDL_EventQ.used == SDL_EventQ.size && !SDL_GrowEvents() ) {
+				/* The rest waits in the ring */
+				break;
+			}
+			SDL_QueueEvent(&slot->entry);
+		}
+
+		SDL_EventQ_Barrier();
+		slot->seq = pos + SDL_EventQ.ring_size;
+		SDL_EventQ.dequeue = pos + 1;
+		/* Full barrier: 'dequeue' is stored before the next slot is read */
+		SDL_EventQ_Add(&SDL_EventQ.count, -1);
+	}
+#if !SDL_EVENTQ_ATOMICS
+	if ( SDL_EventQ.add_lock ) {
+		SDL_mutexV(SDL_EventQ.add_lock);
 	}
 #endif
-	return(added);
+	return(moved);
 }
 
-/* Cut an event, and return the next valid spot, or the tail */
-/*                           -- called with the queue locked */
-static int SDL_CutEvent(int spot)
+/* Cut the oldest event of a lane -- called with the queue locked */
+static void SDL_CutEvent(int type)
 {
-#ifdef SDL_EVENT_WAKEUP_PIPE
-	if (wakeup_pipe[0] != -1) {
-		/* Read one character from the pipe. */
-		char c;
-		read(wakeup_pipe[0], &c, 1);
+	SDL_EventNode *node;
+	int n;
+
+	n = SDL_EventQ.lane_head[type];
+	node = &SDL_EventQ.pending[n];
+	SDL_EventQ.lane_head[type] = node->next;
+	if ( node->next < 0 ) {
+		SDL_EventQ.lane_tail[type] = -1;
+		SDL_EventQ.lanes &= ~SDL_EVENTMASK(type);
+	}
+	if ( type == SDL_MOUSEMOTION &&
+	     node->entry.event.motion.which < SDL_MAXMOUSE &&
+	     SDL_EventQ.last_motion[node->entry.event.motion.which] == n ) {
+		SDL_EventQ.last_motion[node->entry.event.motion.which] = -1;
+	}
+	node->next = SDL_EventQ.free_node;
+	SDL_EventQ.free_node = n;
+	--SDL_EventQ.used;
+}
+
+/* Return the lane in 'lanes' whose head is oldest, following 'cursor' */
+static int SDL_OldestLane(Uint32 lanes, const int *cursor)
+{
+	Uint32 seq = 0;
+	int type, oldest = -1;
+
+	for ( type = 0; lanes; ++type, lanes >>= 1 ) {
+		if ( (lanes & 1) &&
+		     (oldest < 0 ||
+		      (int)(SDL_EventQ.pending[cursor[type]].seq - seq) < 0) ) {
+			oldest = type;
+			seq = SDL_EventQ.pending[cursor[type]].seq;
+		}
+	}
+	return(oldest);
+}
+
+/* Drop the next event in the ring if it is motion -- called with the queue locked */
+static int SDL_DiscardEvent(void)
+{
+	SDL_EventSlot *slot;
+	Uint32 pos;
+	int discarded = 0;
+
+#if !SDL_EVENTQ_ATOMICS
+	if ( SDL_EventQ.add_lock ) {
+		SDL_mutexP(SDL_EventQ.add_lock);
 	}
 #endif
-	if ( spot == SDL_EventQ.head ) {
-		SDL_EventQ.head = (SDL_EventQ.head+1)%MAXEVENTS;
-		return(SDL_EventQ.head);
-	} else
-	if ( (spot+1)%MAXEVENTS == SDL_EventQ.tail ) {
-		SDL_EventQ.tail = spot;
-		return(SDL_EventQ.tail);
-	} else
-	/* We cut the middle -- shift everything over */
-	{
-		int here, next;
+	pos = SDL_EventQ.dequeue;
+	slot = &SDL_EventQ.ring[pos & (SDL_EventQ.ring_size-1)];
+	if ( slot->seq == pos + 1 ) {
+		SDL_EventQ_Barrier();
+		if ( SDL_DISCARDABLEMASK & SDL_EVENTMASK(slot->entry.event.type) ) {
+			slot->seq = pos + SDL_EventQ.ring_size;
+			SDL_EventQ.dequeue = pos + 1;
+			SDL_EventQ_Add(&SDL_EventQ.count, -1);
+			SDL_EventQ_Add(&SDL_EventQ.dropped_motion, 1);
+			discarded = 1;
+		}
+	}
+#if !SDL_EVENTQ_ATOMICS
+	if ( SDL_EventQ.add_lock ) {
+		SDL_mutexV(SDL_EventQ.add_lock);
+	}
+#endif
+	return(discarded);
+}
 
-		/* This can probably be optimized with SDL_memcpy() -- careful! */
-		if ( --SDL_EventQ.tail < 0 ) {
-			SDL_EventQ.tail = MAXEVENTS-1;
+/* Make room in a full ring, return 0 if the event has to be dropped */
+static int SDL_MakeRoom(void)
+{
+	Uint32 lanes;
+	int room;
+
+	room = 0;
+	SDL_mutexP(SDL_EventQ.lock);
+	if ( SDL_MoveEvents() > 0 || SDL_EventQ.used < SDL_EventQ.size ) {
+		/* Moved, or claimed slots are being published right now */
+		room = 1;
+	} else {
+		/* Both are full, give up the oldest motion event */
+		lanes = SDL_EventQ.lanes & SDL_DISCARDABLEMASK;
+		if ( lanes ) {
+			SDL_CutEvent(SDL_OldestLane(lanes, SDL_EventQ.lane_head));
+			SDL_EventQ_Add(&SDL_EventQ.dropped_motion, 1);
+			SDL_MoveEvents();
+			room = 1;
+		} else {
+			/* Or the oldest one still in the ring */
+			room = SDL_DiscardEvent();
 		}
-		for ( here=spot; here != SDL_EventQ.tail; here = next ) {
-			next = (here+1)%MAXEVENTS;
-			SDL_EventQ.event[here] = SDL_EventQ.event[next];
+	}
+	SDL_mutexV(SDL_EventQ.lock);
+	return(room);
+}
+
+/* Add an event to the event queue -- lock-free, from any thread */
+static int SDL_AddEvent(SDL_Event *event)
+{
+	SDL_EventSlot *slot;
+	Uint32 pos;
+	int diff, limit;
+
+	/* Keep the last quarter of the ring for events that can't be discarded */
+	limit = SDL_EventQ.ring_size;
+	if ( SDL_DISCARDABLEMASK & SDL_EVENTMASK(event->type) ) {
+		limit -= limit / 4;
+	}
+#if !SDL_EVENTQ_ATOMICS
+	if ( SDL_EventQ.add_lock ) {
+		SDL_mutexP(SDL_EventQ.add_lock);
+	}
+#endif
+	pos = SDL_EventQ.enqueue;
+	for ( ;; ) {
+		slot = &SDL_EventQ.ring[pos & (SDL_EventQ.ring_size-1)];
+		diff = (int)(slot->seq - pos);
+		if ( diff == 0 && SDL_EventQ.count < limit ) {
+			if ( SDL_EventQ_CAS(&SDL_EventQ.enqueue, pos, pos+1) ) {
+				break;
+			}
+		} else if ( diff <= 0 ) {
+			/* Overflow, move events to the reader side and retry */
+#if !SDL_EVENTQ_ATOMICS
+			if ( SDL_EventQ.add_lock ) {
+				SDL_mutexV(SDL_EventQ.add_lock);
+			}
+#endif
+			if ( !SDL_MakeRoom() ) {
+				SDL_EventQ_Add(&SDL_EventQ.dropped, 1);
+				return(0);
+			}
+#if !SDL_EVENTQ_ATOMICS
+			if ( SDL_EventQ.add_lock ) {
+				SDL_mutexP(SDL_EventQ.add_lock);
+			}
+#endif
+		}
+		pos = SDL_EventQ.enqueue;
+	}
+
+	/* Counted before it is published, so readers never see it negative */
+	SDL_EventQ_Add(&SDL_EventQ.count, 1);
+
+	slot->entry.event = *event;
+	if ( source_timestamp ) {
+		slot->entry.timestamp = source_timestamp;
+	} else {
+		slot->entry.timestamp = SDL_EventTimestampNow();
+	}
+	if (event->type == SDL_SYSWMEVENT) {
+		slot->entry.data.wmmsg = *event->syswm.msg;
+	} else if (event->type == SDL_TOUCHEVENT) {
+		int num = SDL_min(event->touch.num_contacts, SDL_MAXTOUCH);
+		if ( num > 0 ) {
+			SDL_memcpy(slot->entry.data.contacts,
+				event->touch.contacts, num*sizeof(SDL_TouchContact));
 		}
-		return(spot);
+		slot->entry.event.touch.num_contacts = num;
+	}
+	SDL_EventQ_Barrier();
+	slot->seq = pos + 1;
+#if !SDL_EVENTQ_ATOMICS
+	if ( SDL_EventQ.add_lock ) {
+		SDL_mutexV(SDL_EventQ.add_lock);
+	}
+#endif
+
+#ifdef SDL_EVENT_WAKEUP_PIPE
+	/* The reader only stops at a slot that isn't published yet, after
+	   storing its position in 'dequeue'.  Checking it after publishing
+	   means either the reader saw this event, or we see that it stopped
+	   here and wake it up -- even if an earlier producer already did. */
+	SDL_EventQ_Barrier();
+	if ( SDL_EventQ.dequeue == pos ) {
+		SDL_WakeupEvents();
 	}
-	/* NOTREACHED */
+#endif
+	return(1);
 }
 
 /* Lock the event queue, take a peep at it, and unlock it */
@@ -380,16 +1030,25 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	if ( ! SDL_EventQ.active ) {
 		return(-1);
 	}
-	/* Lock the event queue */
+	/* Adding doesn't need the lock */
 	used = 0;
+	if ( action == SDL_ADDEVENT ) {
+		for ( i=0; i<numevents; ++i ) {
+			used += SDL_AddEvent(&events[i]);
+		}
+		return(used);
+	}
+
+	/* Lock the event queue */
 	if ( SDL_mutexP(SDL_EventQ.lock) == 0 ) {
-		if ( action == SDL_ADDEVENT ) {
-			for ( i=0; i<numevents; ++i ) {
-				used += SDL_AddEvent(&events[i]);
-			}
-		} else {
+		SDL_MoveEvents();
+		{
 			SDL_Event tmpevent;
-			int spot;
+			SDL_EventEntry *entry;
+			int peek_cursor[SDL_NUMEVENTS];
+			int *cursor;
+			Uint32 lanes;
+			int type;
 
 			/* If 'events' is NULL, just see if they exist */
 			if ( events == NULL ) {
@@ -397,20 +1056,56 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 				numevents = 1;
 				events = &tmpevent;
 			}
-			spot = SDL_EventQ.head;
-			while ((used < numevents)&&(spot != SDL_EventQ.tail)) {
-				if ( mask & SDL_EVENTMASK(SDL_EventQ.event[spot].type) ) {
-					events[used++] = SDL_EventQ.event[spot];
-					if ( action == SDL_GETEVENT ) {
-						spot = SDL_CutEvent(spot);
-					} else {
-						spot = (spot+1)%MAXEVENTS;
+			lanes = SDL_EventQ.lanes & mask;
+			if ( action == SDL_GETEVENT ) {
+				cursor = SDL_EventQ.lane_head;
+			} else {
+				SDL_memcpy(peek_cursor, SDL_EventQ.lane_head,
+							sizeof(peek_cursor));
+				cursor = peek_cursor;
+			}
+			while ((used < numevents)&&(lanes != 0)) {
+				type = SDL_OldestLane(lanes, cursor);
+				entry = &SDL_EventQ.pending[cursor[type]].entry;
+				events[used] = entry->event;
+				if ( events != &tmpevent ) {
+					last_timestamp = entry->timestamp;
+					if ( SDL_EventRecord && action == SDL_GETEVENT ) {
+						SDL_RecordEvent(&entry->event,
+								entry->timestamp);
 					}
+				}
+				if ( type == SDL_SYSWMEVENT && events != &tmpevent ) {
+					/* Valid until MAXWMMSGS more are returned */
+					int next = SDL_EventQ.wmmsg_next;
+					SDL_EventQ.wmmsg[next] = entry->data.wmmsg;
+					events[used].syswm.msg = &SDL_EventQ.wmmsg[next];
+					SDL_EventQ.wmmsg_next = (next+1)%MAXWMMSGS;
+				}
+				if ( type == SDL_TOUCHEVENT && events != &tmpevent ) {
+					/* Valid until MAXTOUCHES more are returned */
+					int next = SDL_EventQ.touch_next;
+					SDL_memcpy(SDL_EventQ.touch[next],
+						entry->data.contacts,
+						entry->event.touch.num_contacts *
+						sizeof(SDL_TouchContact));
+					events[used].touch.contacts = SDL_EventQ.touch[next];
+					SDL_EventQ.touch_next = (next+1)%MAXTOUCHES;
+				}
+				++used;
+				if ( action == SDL_GETEVENT ) {
+					SDL_CutEvent(type);
 				} else {
-					spot = (spot+1)%MAXEVENTS;
+					cursor[type] = SDL_EventQ.pending[cursor[type]].next;
+				}
+				if ( cursor[type] < 0 ) {
+					lanes &= ~SDL_EVENTMASK(type);
 				}
 			}
 		}
+		if ( used == 0 && action == SDL_GETEVENT ) {
+			SDL_ReplayDrained();
+		}
 		SDL_mutexV(SDL_EventQ.lock);
 	} else {
 		SDL_SetError("Couldn't lock event queue");
@@ -419,6 +1114,29 @@ int SDL_PeepEvents(SDL_Event *events, int numevents, SDL_eventaction action,
 	return(used);
 }
 
+Uint64 SDL_GetEventTimestamp(void)
+{
+	return(last_timestamp);
+}
+
+void SDL_GetEventQueueStats(SDL_EventQueueStats *stats)
+{
+	stats->capacity = SDL_EventQ.ring_size + SDL_EventQ.size;
+	stats->max_capacity = SDL_EventQ.ring_size + SDL_EventQ.max_size;
+	stats->high_water = SDL_EventQ.high_water;
+	stats->dropped = SDL_EventQ.dropped;
+	stats->dropped_motion = SDL_EventQ.dropped_motion;
+	stats->coalesced = SDL_EventQ.coalesced;
+}
+
+void SDL_ResetEventQueueStats(void)
+{
+	SDL_EventQ.high_water = 0;
+	SDL_EventQ.dropped = 0;
+	SDL_EventQ.dropped_motion = 0;
+	SDL_EventQ.coalesced = 0;
+}
+
 /* Run the system dependent event loops */
 void SDL_PumpEvents(void)
 {
@@ -440,36 +1158,90 @@ void SDL_PumpEvents(void)
 			SDL_JoystickUpdate();
 		}
 #endif
+
+		/* Queue recorded events that are due */
+		SDL_PumpReplay();
 	}
 }
 
-void SDL_WaitForEvent(void)
+/* Sleep until an event may be pending, at most 'timeout' ms unless -1 */
+static void SDL_WaitForEvent(int timeout)
 {
+	int repeat = SDL_KeyRepeatTimeout();
+	int replay = SDL_ReplayTimeout();
+
+	if ( repeat >= 0 && (timeout < 0 || repeat < timeout) ) {
+		timeout = repeat;
+	}
+	if ( replay >= 0 && (timeout < 0 || replay < timeout) ) {
+		timeout = replay;
+	}
 #ifdef SDL_EVENT_WAKEUP_PIPE
-	int can_select = current_video && current_video->can_select &&
-		wakeup_pipe[0] != -1 &&
-		(SDL_numjoysticks == 0 || !(SDL_eventstate & SDL_JOYEVENTMASK));
-	if (can_select) {
+	if ( current_video && current_video->can_select &&
+	     wakeup_pipe[0] != -1 && lost_event_sources == 0 ) {
 		int vfd = current_video->monitor_fd;
-		int nfds;
-		fd_set rfds;
+		int joysticks = (SDL_numjoysticks != 0 &&
+				 (SDL_eventstate & SDL_JOYEVENTMASK));
+#ifdef SDL_EVENT_EPOLL
+#if SDL_JOYSTICK_LINUX
+		/* Open joysticks are event sources */
+		joysticks = 0;
+#endif
+		if ( epoll_fd != -1 && !joysticks ) {
+			struct epoll_event ev[MAXSOURCES+2];
+			int watch = ((SDL_eventstate & SDL_JOYEVENTMASK) != 0);
 
-		FD_ZERO(&rfds);
-		FD_SET(wakeup_pipe[0], &rfds);
-		nfds = wakeup_pipe[0] + 1;
+			if ( watch != epoll_sources ) {
+				SDL_WatchSources(watch);
+			}
 
-		if ( vfd != -1 ) {
-			/* Also monitor video device FD if any. */
-			FD_SET(vfd, &rfds);
-			if (vfd + 1 > nfds) nfds = vfd + 1;
+			if ( vfd != epoll_video_fd ) {
+				if ( epoll_video_fd != -1 ) {
+					epoll_ctl(epoll_fd, EPOLL_CTL_DEL,
+						  epoll_video_fd, &ev[0]);
+				}
+				if ( vfd != -1 ) {
+					SDL_WatchSource(vfd);
+				}
+				epoll_video_fd = vfd;
+			}
+			if ( epoll_wait(epoll_fd, ev, SDL_arraysize(ev), timeout) > 0 ) {
+				/* The queue is checked again before the next wait */
+				SDL_ClearWakeup();
+			}
+			return;
 		}
+#endif
+		if ( !joysticks ) {
+			struct timeval tv;
+			int nfds;
+			fd_set rfds;
+
+			FD_ZERO(&rfds);
+			FD_SET(wakeup_pipe[0], &rfds);
+			nfds = wakeup_pipe[0] + 1;
+
+			if ( vfd != -1 ) {
+				/* Also monitor video device FD if any. */
+				FD_SET(vfd, &rfds);
+				if (vfd + 1 > nfds) nfds = vfd + 1;
+			}
 
-		select(nfds, &rfds, NULL, NULL, NULL);
-
-		return;
+			tv.tv_sec = timeout / 1000;
+			tv.tv_usec = (timeout % 1000) * 1000;
+			if ( select(nfds, &rfds, NULL, NULL,
+				    timeout < 0 ? NULL : &tv) > 0 &&
+			     FD_ISSET(wakeup_pipe[0], &rfds) ) {
+				SDL_ClearWakeup();
+			}
+			return;
+		}
 	}
 #endif
-	SDL_Delay(10);
+	if ( timeout < 0 || timeout > 10 ) {
+		timeout = 10;
+	}
+	SDL_Delay(timeout);
 }
 
 /* Public functions */
@@ -486,12 +1258,33 @@ int SDL_PollEvent (SDL_Event *event)
 
 int SDL_WaitEvent (SDL_Event *event)
 {
+	return SDL_WaitEventTimeout(event, -1);
+}
+
+int SDL_WaitEventTimeout (SDL_Event *event, int timeout)
+{
+	Uint32 expiration = 0;
+	int left = -1;
+
+	if ( timeout > 0 ) {
+		expiration = SDL_GetTicks() + timeout;
+	}
 	while ( 1 ) {
 		SDL_PumpEvents();
 		switch(SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_ALLEVENTS)) {
 		    case -1: return 0;
 		    case 1: return 1;
-		    case 0: SDL_WaitForEvent();
+		    case 0:
+			if ( timeout == 0 ) {
+				return 0;
+			}
+			if ( timeout > 0 ) {
+				left = (int)(expiration - SDL_GetTicks());
+				if ( left <= 0 ) {
+					return 0;
+				}
+			}
+			SDL_WaitForEvent(left);
 		}
 	}
 }
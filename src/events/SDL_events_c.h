@@ -23,6 +23,7 @@
 
 /* Useful functions and variables from SDL_events.c */
 #include "SDL_events.h"
+#include "SDL_rwops.h"
 
 /* Start and stop the event processing loop */
 extern int SDL_StartEventLoop(Uint32 flags);
@@ -31,6 +32,8 @@ extern void SDL_QuitInterrupt(void);
 
 extern void SDL_Lock_EventThread(void);
 extern void SDL_Unlock_EventThread(void);
+extern void SDL_Lock_EventQueue(void);
+extern void SDL_Unlock_EventQueue(void);
 extern Uint32 SDL_EventThreadID(void);
 
 /* Event handler init routines */
@@ -62,6 +65,7 @@ extern int SDL_PrivateMouseMotion(Uint8 buttonstate, int relative,
 extern int SDL_PrivateMultiMouseButton(int which, Uint8 state, Uint8 button,
 						Sint16 x, Sint16 y);
 extern int SDL_PrivateMouseButton(Uint8 state, Uint8 button,Sint16 x,Sint16 y);
+extern int SDL_PrivateTouch(int num_contacts, const SDL_TouchContact *contacts);
 extern int SDL_PrivateKeyboard(Uint8 state, SDL_keysym *key);
 extern int SDL_PrivateResize(int w, int h);
 extern int SDL_PrivateExpose(void);
@@ -81,6 +85,28 @@ extern void SDL_ResetKeyboard(void);
 /* Used by the event loop to queue pending keyboard repeat events */
 extern void SDL_CheckKeyRepeat(void);
 
+/* Used by the event loop to sleep until the next keyboard repeat event,
+   returns the delay in milliseconds or -1 if no key is repeating */
+extern int SDL_KeyRepeatTimeout(void);
+
+/* Event recording and replay (from SDL_record.c) */
+extern SDL_RWops *SDL_EventRecord;
+extern void SDL_RecordEvent(const SDL_Event *event, Uint64 timestamp);
+extern void SDL_PumpReplay(void);
+extern void SDL_ReplayDrained(void);
+extern int SDL_ReplayTimeout(void);
+
+/* Used by input drivers to stamp the events they queue with the time the
+   input happened, from SDL_EventTimestampNow() or the same clock.  Zero
+   stamps events with the time they are queued, which is the default. */
+extern Uint64 SDL_EventTimestampNow(void);
+extern void SDL_SetEventSourceTime(Uint64 timestamp);
+
+/* Used by input drivers to let SDL_WaitEvent() sleep on their descriptors,
+   remove it before the descriptor is closed */
+extern void SDL_AddEventSource(int fd);
+extern void SDL_RemoveEventSource(int fd);
+
 /* Used by the OS keyboard code to detect whether or not to do UNICODE */
 #ifndef DEFAULT_UNICODE_TRANSLATION
 #define DEFAULT_UNICODE_TRANSLATION 0	/* Default off because of overhead */
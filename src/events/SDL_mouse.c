@@ -39,10 +39,16 @@ static Uint8  SDL_ButtonState[SDL_MAXMOUSE];
 static Sint16 SDL_MouseMaxX;
 static Sint16 SDL_MouseMaxY;
 
+/* Touch screen state: fingers reported as mice, and down in the last frame */
+static int SDL_TouchMouse;
+static Uint16 SDL_TouchMice;
+static int SDL_TouchDown;
+
 /* Public functions */
 int SDL_MouseInit(void)
 {
 	/* The mouse is at (0,0) */
+	const char *env;
 	int i;
 	for (i = 0; i < SDL_MAXMOUSE; i++) {
 		SDL_MouseX[i] = 0;
@@ -55,6 +61,11 @@ int SDL_MouseInit(void)
 	SDL_MouseMaxX = 0;
 	SDL_MouseMaxY = 0;
 
+	env = SDL_getenv("SDL_TOUCH_MOUSE");
+	SDL_TouchMouse = (env && SDL_atoi(env));
+	SDL_TouchMice = 0;
+	SDL_TouchDown = 0;
+
 	/* That's it! */
 	return(0);
 }
@@ -308,3 +319,69 @@ int SDL_PrivateMouseButton(Uint8 state, Uint8 button, Sint16 x, Sint16 y)
 	return SDL_PrivateMultiMouseButton(0, state, button, x, y);
 }
 
+
+/* The fingers down on a touch screen after each of its frames */
+int SDL_PrivateTouch(int num_contacts, const SDL_TouchContact *contacts)
+{
+	int posted;
+	Uint16 down;
+	int i;
+
+	if ( num_contacts > SDL_MAXTOUCH ) {
+		num_contacts = SDL_MAXTOUCH;
+	}
+
+	/* Post the event, if desired */
+	posted = 0;
+	if ( SDL_ProcessEvents[SDL_TOUCHEVENT] == SDL_ENABLE &&
+	     (num_contacts || SDL_TouchDown) ) {
+		SDL_TouchContact touch[SDL_MAXTOUCH];
+		SDL_Event event;
+
+		for ( i = 0; i < num_contacts; ++i ) {
+			touch[i] = contacts[i];
+			ClipOffset(&touch[i].x, &touch[i].y);
+			touch[i].x = SDL_max(0, SDL_min(touch[i].x, SDL_MouseMaxX-1));
+			touch[i].y = SDL_max(0, SDL_min(touch[i].y, SDL_MouseMaxY-1));
+		}
+		SDL_memset(&event, 0, sizeof(event));
+		event.type = SDL_TOUCHEVENT;
+		event.touch.num_contacts = num_contacts;
+		event.touch.contacts = touch;
+		if ( (SDL_EventOK == NULL) || (*SDL_EventOK)(&event) ) {
+			posted = 1;
+			SDL_PushEvent(&event);
+		}
+	}
+	SDL_TouchDown = num_contacts;
+
+	/* Applications not taking touch events see one mouse per finger,
+	   with the left button pressed while the finger is down */
+	down = 0;
+	if ( SDL_ProcessEvents[SDL_TOUCHEVENT] != SDL_ENABLE || SDL_TouchMouse ) {
+		for ( i = 0; i < num_contacts; ++i ) {
+			int which = contacts[i].id;
+			if ( which >= SDL_MAXMOUSE ) {
+				continue;
+			}
+			down |= (1 << which);
+			if ( SDL_ButtonState[which] ) {
+				SDL_PrivateMultiMouseMotion(which, SDL_BUTTON_LMASK, 0,
+					contacts[i].x, contacts[i].y);
+			} else {
+				SDL_PrivateMultiMouseMotion(which, 0, 0,
+					contacts[i].x, contacts[i].y);
+				SDL_PrivateMultiMouseButton(which, SDL_PRESSED,
+					SDL_BUTTON_LEFT, 0, 0);
+			}
+		}
+	}
+	/* Release the mice of lifted fingers */
+	for ( i = 0; i < SDL_MAXMOUSE; ++i ) {
+		if ( (SDL_TouchMice & ~down) & (1 << i) ) {
+			SDL_ResetMultiMouse(i);
+		}
+	}
+	SDL_TouchMice = down;
+	return(posted);
+}
@@ -0,0 +1,265 @@
+/*
+    SDL - Simple DirectMedia Layer
+    Copyright (C) 1997-2009 Sam Lantinga
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Sam Lantinga
+    slouken@libsdl.org
+*/
+#include "SDL_config.h"
+
+/* Event recording and replay for SDL */
+
+#include "SDL_events.h"
+#include "SDL_rwops.h"
+#include "SDL_timer.h"
+#include "SDL_events_c.h"
+
+/*
+ * A recording is a header followed by one record per event returned by
+ *  SDL_PeepEvents():
+ *	Uint32 magic, Uint32 version
+ *	Uint32 ticks since the recording started, Uint64 timestamp,
+ *	Uint8 type, Uint8 size, 'size' bytes of the event structure
+ * All integers are little endian.  The event structures are stored as they
+ *  are in memory, so a recording is only meant to be replayed on the same
+ *  platform.  SYSWM, touch and user events are not recorded: they point
+ *  to data that isn't serialized, or the application will post them
+ *  again itself.
+ */
+#define RECORD_MAGIC	0x56454C53	/* "SLEV" */
+#define RECORD_VERSION	1
+#define RECORD_HEADER	14
+
+/* This is global for SDL_events.c */
+SDL_RWops *SDL_EventRecord = NULL;
+static Uint32 record_start;
+
+static struct {
+	SDL_RWops *src;
+	int fast;
+	int drained;
+	Uint32 start;
+	Uint64 offset;
+
+	/* The next event to inject */
+	Uint32 ticks;
+	Uint64 timestamp;
+	SDL_Event event;
+} replay;
+
+static int SDL_RecordSize(Uint8 type)
+{
+	switch (type) {
+	    case SDL_ACTIVEEVENT:
+		return(sizeof(SDL_ActiveEvent));
+	    case SDL_KEYDOWN:
+	    case SDL_KEYUP:
+		return(sizeof(SDL_KeyboardEvent));
+	    case SDL_MOUSEMOTION:
+		return(sizeof(SDL_MouseMotionEvent));
+	    case SDL_MOUSEBUTTONDOWN:
+	    case SDL_MOUSEBUTTONUP:
+		return(sizeof(SDL_MouseButtonEvent));
+	    case SDL_JOYAXISMOTION:
+		return(sizeof(SDL_JoyAxisEvent));
+	    case SDL_JOYBALLMOTION:
+		return(sizeof(SDL_JoyBallEvent));
+	    case SDL_JOYHATMOTION:
+		return(sizeof(SDL_JoyHatEvent));
+	    case SDL_JOYBUTTONDOWN:
+	    case SDL_JOYBUTTONUP:
+		return(sizeof(SDL_JoyButtonEvent));
+	    case SDL_QUIT:
+		return(sizeof(SDL_QuitEvent));
+	    case SDL_VIDEORESIZE:
+		return(sizeof(SDL_ResizeEvent));
+	    case SDL_VIDEOEXPOSE:
+		return(sizeof(SDL_ExposeEvent));
+	}
+	return(0);
+}
+
+static void SDL_PutLE(Uint8 *p, Uint64 value, int len)
+{
+	int i;
+
+	for ( i = 0; i < len; ++i ) {
+		p[i] = (Uint8)(value >> (i * 8));
+	}
+}
+
+static Uint64 SDL_GetLE(const Uint8 *p, int len)
+{
+	Uint64 value = 0;
+	int i;
+
+	for ( i = len-1; i >= 0; --i ) {
+		value = (value << 8) | p[i];
+	}
+	return(value);
+}
+
+/* Called with the event queue locked */
+void SDL_RecordEvent(const SDL_Event *event, Uint64 timestamp)
+{
+	Uint8 header[RECORD_HEADER];
+	int size = SDL_RecordSize(event->type);
+
+	if ( size == 0 ) {
+		return;
+	}
+	SDL_PutLE(&header[0], SDL_GetTicks() - record_start, 4);
+	SDL_PutLE(&header[4], timestamp, 8);
+	header[12] = event->type;
+	header[13] = (Uint8)size;
+	if ( (SDL_RWwrite(SDL_EventRecord, header, sizeof(header), 1) != 1) ||
+	     (SDL_RWwrite(SDL_EventRecord, event, size, 1) != 1) ) {
+		/* Out of space, keep what was written */
+		SDL_EventRecord = NULL;
+	}
+}
+
+int SDL_RecordEvents(SDL_RWops *dst)
+{
+	Uint8 header[8];
+
+	SDL_Lock_EventQueue();
+	SDL_EventRecord = NULL;
+	if ( dst ) {
+		SDL_PutLE(&header[0], RECORD_MAGIC, 4);
+		SDL_PutLE(&header[4], RECORD_VERSION, 4);
+		if ( SDL_RWwrite(dst, header, sizeof(header), 1) != 1 ) {
+			SDL_Unlock_EventQueue();
+			SDL_SetError("Couldn't write event recording");
+			return(-1);
+		}
+		record_start = SDL_GetTicks();
+		SDL_EventRecord = dst;
+	}
+	SDL_Unlock_EventQueue();
+	return(0);
+}
+
+/* Read the next record, return 0 at the end of the recording */
+static int SDL_ReadRecord(void)
+{
+	Uint8 header[RECORD_HEADER];
+	int size;
+
+	if ( SDL_RWread(replay.src, header, sizeof(header), 1) != 1 ) {
+		return(0);
+	}
+	replay.ticks = (Uint32)SDL_GetLE(&header[0], 4);
+	replay.timestamp = SDL_GetLE(&header[4], 8);
+	size = header[13];
+	if ( size == 0 || size > sizeof(SDL_Event) ||
+	     size != SDL_RecordSize(header[12]) ) {
+		SDL_SetError("Corrupt event recording");
+		return(0);
+	}
+	SDL_memset(&replay.event, 0, sizeof(replay.event));
+	if ( SDL_RWread(replay.src, &replay.event, size, 1) != 1 ) {
+		return(0);
+	}
+	replay.event.type = header[12];
+	return(1);
+}
+
+int SDL_ReplayEvents(SDL_RWops *src, int fast)
+{
+	Uint8 header[8];
+
+	replay.src = NULL;
+	if ( src == NULL ) {
+		return(0);
+	}
+	if ( (SDL_RWread(src, header, sizeof(header), 1) != 1) ||
+	     (SDL_GetLE(&header[0], 4) != RECORD_MAGIC) ||
+	     (SDL_GetLE(&header[4], 4) != RECORD_VERSION) ) {
+		SDL_SetError("Not an event recording");
+		return(-1);
+	}
+	replay.src = src;
+	if ( ! SDL_ReadRecord() ) {
+		replay.src = NULL;
+		return(0);
+	}
+	replay.fast = fast;
+	replay.drained = 1;
+	replay.start = SDL_GetTicks() - replay.ticks;
+	replay.offset = SDL_EventTimestampNow() - replay.timestamp;
+	return(0);
+}
+
+/* Inject the next event and read the one after it */
+static void SDL_ReplayEvent(void)
+{
+	SDL_SetEventSourceTime(replay.timestamp + replay.offset);
+	SDL_PeepEvents(&replay.event, 1, SDL_ADDEVENT, 0);
+	SDL_SetEventSourceTime(0);
+	if ( ! SDL_ReadRecord() ) {
+		replay.src = NULL;
+	}
+}
+
+/* Called from the event loop to inject recorded events that are due */
+void SDL_PumpReplay(void)
+{
+	Uint32 ticks;
+
+	if ( replay.src == NULL ) {
+		return;
+	}
+	if ( replay.fast ) {
+		/* One batch at a time, once the application saw the queue empty */
+		if ( ! replay.drained ) {
+			return;
+		}
+		replay.drained = 0;
+		ticks = replay.ticks;
+		do {
+			SDL_ReplayEvent();
+		} while ( replay.src && replay.ticks == ticks );
+	} else {
+		ticks = SDL_GetTicks() - replay.start;
+		while ( replay.src && (Sint32)(ticks - replay.ticks) >= 0 ) {
+			SDL_ReplayEvent();
+		}
+	}
+}
+
+/* Used by the event loop to sleep until the next recorded event is due,
+   returns the delay in milliseconds or -1 if nothing is being replayed */
+int SDL_ReplayTimeout(void)
+{
+	Sint32 due;
+
+	if ( replay.src == NULL ) {
+		return(-1);
+	}
+	if ( replay.fast ) {
+		return(replay.drained ? 0 : -1);
+	}
+	due = (Sint32)(replay.ticks - (SDL_GetTicks() - replay.start));
+	return(due > 0 ? due : 0);
+}
+
+/* Called when SDL_PeepEvents() found nothing to get */
+void SDL_ReplayDrained(void)
+{
+	replay.drained = 1;
+}
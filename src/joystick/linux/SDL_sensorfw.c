@@ -11,6 +11,7 @@
 #include "SDL_events.h"
 #include "../SDL_sysjoystick.h"
 #include "../SDL_joystick_c.h"
+#include "../../events/SDL_events_c.h"
 
 #include "SDL_sensorfw.h"
 
@@ -119,6 +120,13 @@ static void update_button(SDL_Joystick *joystick, Uint8 button,
 
 static void process_packet(SDL_Joystick *joystick, Sensor *s, void *data)
 {
+#if HAVE_CLOCK_GETTIME
+	/* Every packet starts with its CLOCK_MONOTONIC time in microseconds */
+	long long timestamp;
+
+	SDL_memcpy(&timestamp, data, sizeof(timestamp));
+	SDL_SetEventSourceTime(timestamp);
+#endif
 	switch (s->type) {
 		case ACCELEROMETER: {
 			AccelerometerData *d = (AccelerometerData *)data;
@@ -148,6 +156,7 @@ static void process_packet(SDL_Joystick *joystick, Sensor *s, void *data)
 		}
 		break;
 	}
+	SDL_SetEventSourceTime(0);
 }
 
 static Sensor * find_sensor_by_sdl_id(int sdl_id)
@@ -367,6 +376,7 @@ static int open_socket(Sensor *s)
 	DPRINT("Opened socket fd=%d for %s session %d\n",
 		fd, s->sfw_name, s->session_id);
 	s->fd = fd;
+	SDL_AddEventSource(fd);
 
 	return 0;
 }
@@ -374,6 +384,7 @@ static int open_socket(Sensor *s)
 static void close_socket(Sensor *s)
 {
 	DPRINT("Closing socket %d for %s\n", s->fd, s->sfw_name);
+	SDL_RemoveEventSource(s->fd);
 	close(s->fd);
 	s->fd = -1;
 }
@@ -30,6 +30,9 @@
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <limits.h>		/* For the definition of PATH_MAX */
+#if HAVE_CLOCK_GETTIME
+#include <time.h>		/* For CLOCK_MONOTONIC */
+#endif
 #include <linux/joystick.h>
 #if SDL_INPUT_LINUXEV
 #include <linux/input.h>
@@ -38,6 +41,7 @@
 #include "SDL_joystick.h"
 #include "../SDL_sysjoystick.h"
 #include "../SDL_joystick_c.h"
+#include "../../events/SDL_events_c.h"
 
 #if SDL_JOYSTICK_LINUX_SENSORFW
 #include "SDL_sensorfw.h"
@@ -290,6 +294,7 @@ struct joystick_hwdata {
 	/* Support for the Linux 2.4 unified input interface */
 #if SDL_INPUT_LINUXEV
 	SDL_bool is_hid;
+	SDL_bool has_time;	/* input_event time is on the event clock */
 	Uint8 key_map[KEY_MAX-BTN_MISC];
 	Uint8 abs_map[ABS_MAX];
 	struct axis_correct {
@@ -687,6 +692,16 @@ static SDL_bool EV_ConfigJoystick(SDL_Joystick *joystick, int fd)
 	     (ioctl(fd, EVIOCGBIT(EV_REL, sizeof(relbit)), relbit) >= 0) ) {
 		joystick->hwdata->is_hid = SDL_TRUE;
 
+		/* Have the kernel stamp events with the event queue clock */
+#if HAVE_CLOCK_GETTIME
+#ifdef EVIOCSCLOCKID
+		t = CLOCK_MONOTONIC;
+		joystick->hwdata->has_time = (ioctl(fd, EVIOCSCLOCKID, &t) == 0);
+#endif
+#else
+		joystick->hwdata->has_time = SDL_TRUE;
+#endif
+
 		/* Get the number of buttons, axes, and other thingamajigs */
 		for ( i=BTN_JOYSTICK; i < KEY_MAX; ++i ) {
 			if ( test_bit(i, keybit) ) {
@@ -843,6 +858,9 @@ int SDL_SYS_JoystickOpen(SDL_Joystick *joystick)
 	/* Set the joystick to non-blocking read mode */
 	fcntl(fd, F_SETFL, O_NONBLOCK);
 
+	/* Wake up SDL_WaitEvent() on input */
+	SDL_AddEventSource(fd);
+
 	/* Get the number of buttons and axes on the joystick */
 #ifndef NO_LOGICAL_JOYSTICKS
 	if (realjoy)
@@ -1096,6 +1114,11 @@ static __inline__ void EV_HandleEvents(SDL_Joystick *joystick)
 		len /= sizeof(events[0]);
 		for ( i=0; i<len; ++i ) {
 			code = events[i].code;
+			if ( joystick->hwdata->has_time ) {
+				SDL_SetEventSourceTime(
+					(Uint64)events[i].time.tv_sec * 1000000 +
+					events[i].time.tv_usec);
+			}
 			switch (events[i].type) {
 			    case EV_KEY:
 				if ( code >= BTN_MISC ) {
@@ -1154,6 +1177,7 @@ static __inline__ void EV_HandleEvents(SDL_Joystick *joystick)
 			}
 		}
 	}
+	SDL_SetEventSourceTime(0);
 }
 #endif /* SDL_INPUT_LINUXEV */
 
@@ -1211,7 +1235,10 @@ void SDL_SYS_JoystickClose(SDL_Joystick *joystick)
 #ifndef NO_LOGICAL_JOYSTICKS
 		if (SDL_joylist[joystick->index].fname != NULL)
 #endif
-		close(joystick->hwdata->fd);
+		{
+			SDL_RemoveEventSource(joystick->hwdata->fd);
+			close(joystick->hwdata->fd);
+		}
 		if ( joystick->hwdata->hats ) {
 			SDL_free(joystick->hwdata->hats);
 		}
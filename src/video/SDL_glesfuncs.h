@@ -106,8 +106,8 @@ SDL_PROC_UNUSED(void,glGetBooleanv,(GLenum pname, GLboolean *params))
 SDL_PROC_UNUSED(void,glGetClipPlane,(GLenum plane, GLfloat *equation))
 SDL_PROC_UNUSED(void,glGetDoublev,(GLenum pname, GLfloat *params))
 SDL_PROC_UNUSED(GLenum,glGetError,(void))
-SDL_PROC_UNUSED(void,glGetFloatv,(GLenum pname, GLfloat *params))
-SDL_PROC_UNUSED(void,glGetIntegerv,(GLenum pname, GLint *params))
+SDL_PROC(void,glGetFloatv,(GLenum pname, GLfloat *params))
+SDL_PROC(void,glGetIntegerv,(GLenum pname, GLint *params))
 SDL_PROC_UNUSED(void,glGetLightfv,(GLenum light, GLenum pname, GLfloat *params))
 SDL_PROC_UNUSED(void,glGetLightiv,(GLenum light, GLenum pname, GLint *params))
 SDL_PROC_UNUSED(void,glGetMapdv,(GLenum target, GLenum query, GLfloat *v))
@@ -122,7 +122,7 @@ SDL_PROC_UNUSED(void,glGetPointerv,(GLenum pname, GLvoid* *params))
 SDL_PROC_UNUSED(void,glGetPolygonStipple,(GLubyte *mask))
 SDL_PROC(const GLubyte *,glGetString,(GLenum name))
 SDL_PROC_UNUSED(void,glGetTexEnvfv,(GLenum target, GLenum pname, GLfloat *params))
-SDL_PROC_UNUSED(void,glGetTexEnviv,(GLenum target, GLenum pname, GLint *params))
+SDL_PROC(void,glGetTexEnviv,(GLenum target, GLenum pname, GLint *params))
 SDL_PROC_UNUSED(void,glGetTexGendv,(GLenum coord, GLenum pname, GLfloat *params))
 SDL_PROC_UNUSED(void,glGetTexGenfv,(GLenum coord, GLenum pname, GLfloat *params))
 SDL_PROC_UNUSED(void,glGetTexGeniv,(GLenum coord, GLenum pname, GLint *params))
@@ -146,7 +146,7 @@ SDL_PROC_UNUSED(void,glIndexub,(GLubyte c))
 SDL_PROC_UNUSED(void,glIndexubv,(const GLubyte *c))
 SDL_PROC_UNUSED(void,glInitNames,(void))
 SDL_PROC_UNUSED(void,glInterleavedArrays,(GLenum format, GLsizei stride, const GLvoid *pointer))
-SDL_PROC_UNUSED(GLboolean,glIsEnabled,(GLenum cap))
+SDL_PROC(GLboolean,glIsEnabled,(GLenum cap))
 SDL_PROC_UNUSED(GLboolean,glIsList,(GLuint list))
 SDL_PROC_UNUSED(GLboolean,glIsTexture,(GLuint texture))
 SDL_PROC_UNUSED(void,glLightModelf,(GLenum pname, GLfloat param))
@@ -295,7 +295,7 @@ SDL_PROC_UNUSED(void,glTexCoord4sv,(const GLshort *v))
 SDL_PROC(void,glTexCoordPointer,(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer))
 SDL_PROC(void,glTexEnvf,(GLenum target, GLenum pname, GLfloat param))
 SDL_PROC_UNUSED(void,glTexEnvfv,(GLenum target, GLenum pname, const GLfloat *params))
-SDL_PROC_UNUSED(void,glTexEnvi,(GLenum target, GLenum pname, GLint param))
+SDL_PROC(void,glTexEnvi,(GLenum target, GLenum pname, GLint param))
 SDL_PROC_UNUSED(void,glTexEnviv,(GLenum target, GLenum pname, const GLint *params))
 SDL_PROC_UNUSED(void,glTexGend,(GLenum coord, GLenum pname, GLfloat param))
 SDL_PROC_UNUSED(void,glTexGendv,(GLenum coord, GLenum pname, const GLfloat *params))
@@ -29,6 +29,8 @@
 
 #include "SDL_video.h"
 #include "SDL_blit.h"
+#include "SDL_sysvideo.h"
+#include "SDL_pixels_c.h"
 
 /* This isn't ready for general consumption yet - it should be folded
    into the general blitting mechanism.
@@ -356,3 +358,93 @@ int SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
 	return(0);
 }
 
+/* Perform a stretch blit, in hardware when the driver can do it */
+int SDL_StretchBlit(SDL_Surface *src, SDL_Rect *srcrect,
+                    SDL_Surface *dst, SDL_Rect *dstrect,
+                    SDL_StretchFilter filter)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_Rect full_src;
+	SDL_Rect full_dst;
+	SDL_Rect hw_srcrect;
+	SDL_Rect hw_dstrect;
+	int retval;
+
+	if ( ! src || ! dst ) {
+		SDL_SetError("SDL_StretchBlit: passed a NULL surface");
+		return(-1);
+	}
+	if ( src->locked || dst->locked ) {
+		SDL_SetError("Surfaces must not be locked during blit");
+		return(-1);
+	}
+
+	if ( ! srcrect ) {
+		full_src.x = 0;
+		full_src.y = 0;
+		full_src.w = src->w;
+		full_src.h = src->h;
+		srcrect = &full_src;
+	}
+	if ( ! dstrect ) {
+		full_dst.x = 0;
+		full_dst.y = 0;
+		full_dst.w = dst->w;
+		full_dst.h = dst->h;
+		dstrect = &full_dst;
+	}
+	if ( !srcrect->w || !srcrect->h || !dstrect->w || !dstrect->h ) {
+		return(0);
+	}
+
+	/* Only accelerate when both surfaces live in video memory and
+	   the driver's blitter can scale, most just copy srcrect->w/h */
+	if ( !video || !video->stretch_blit ||
+	     (src->flags & SDL_HWSURFACE) != SDL_HWSURFACE ||
+	     (dst->flags & SDL_HWSURFACE) != SDL_HWSURFACE ) {
+		return(SDL_SoftStretch(src, srcrect, dst, dstrect));
+	}
+
+	if ( (srcrect->x < 0) || (srcrect->y < 0) ||
+	     ((srcrect->x+srcrect->w) > src->w) ||
+	     ((srcrect->y+srcrect->h) > src->h) ) {
+		SDL_SetError("Invalid source blit rectangle");
+		return(-1);
+	}
+	if ( (dstrect->x < 0) || (dstrect->y < 0) ||
+	     ((dstrect->x+dstrect->w) > dst->w) ||
+	     ((dstrect->y+dstrect->h) > dst->h) ) {
+		SDL_SetError("Invalid destination blit rectangle");
+		return(-1);
+	}
+
+	/* Check to make sure the blit mapping is valid */
+	if ( (src->map->dst != dst) ||
+             (src->map->dst->format_version != src->map->format_version) ) {
+		if ( SDL_MapSurface(src, dst) < 0 ) {
+			return(-1);
+		}
+	}
+	if ( (src->flags & SDL_HWACCEL) != SDL_HWACCEL ) {
+		return(SDL_SoftStretch(src, srcrect, dst, dstrect));
+	}
+
+	if ( src == SDL_VideoSurface ) {
+		hw_srcrect = *srcrect;
+		hw_srcrect.x += video->offset_x;
+		hw_srcrect.y += video->offset_y;
+		srcrect = &hw_srcrect;
+	}
+	if ( dst == SDL_VideoSurface ) {
+		hw_dstrect = *dstrect;
+		hw_dstrect.x += video->offset_x;
+		hw_dstrect.y += video->offset_y;
+		dstrect = &hw_dstrect;
+	}
+
+	video->stretch_filter = filter;
+	retval = src->map->hw_blit(src, srcrect, dst, dstrect);
+	video->stretch_filter = SDL_STRETCH_AUTO;
+
+	return(retval);
+}
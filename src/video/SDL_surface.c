@@ -736,13 +736,36 @@ int SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
  * Lock a surface to directly access the pixels
  */
 int SDL_LockSurface (SDL_Surface *surface)
+{
+	return SDL_LockSurfaceEx(surface, SDL_LOCK_READ|SDL_LOCK_WRITE, NULL);
+}
+int SDL_LockSurfaceEx (SDL_Surface *surface, Uint32 flags, const SDL_Rect *rect)
 {
 	if ( ! surface->locked ) {
 		/* Perform the lock */
 		if ( surface->flags & (SDL_HWSURFACE|SDL_ASYNCBLIT) ) {
 			SDL_VideoDevice *video = current_video;
 			SDL_VideoDevice *this  = current_video;
-			if ( video->LockHWSurface(this, surface) < 0 ) {
+			SDL_Rect full, area;
+
+			if ( ! flags ) {
+				flags = SDL_LOCK_READ|SDL_LOCK_WRITE;
+			}
+			if ( flags & SDL_LOCK_DISCARD ) {
+				flags |= SDL_LOCK_WRITE;
+			}
+			if ( rect ) {
+				full.x = full.y = 0;
+				full.w = surface->w;
+				full.h = surface->h;
+				SDL_IntersectRect(&full, rect, &area);
+				rect = &area;
+			}
+			if ( video->LockHWSurfaceEx ) {
+				if ( video->LockHWSurfaceEx(this, surface, flags, rect) < 0 ) {
+					return(-1);
+				}
+			} else if ( video->LockHWSurface(this, surface) < 0 ) {
 				return(-1);
 			}
 		}
@@ -146,12 +146,21 @@ struct SDL_VideoDevice {
 	int (*LockHWSurface)(_THIS, SDL_Surface *surface);
 	void (*UnlockHWSurface)(_THIS, SDL_Surface *surface);
 
+	/* Optional, LockHWSurface with SDL_LOCK_* hints and a clipped rect */
+	int (*LockHWSurfaceEx)(_THIS, SDL_Surface *surface, Uint32 flags, const SDL_Rect *rect);
+
 	/* Performs hardware flipping */
 	int (*FlipHWSurface)(_THIS, SDL_Surface *surface);
 
 	/* Frees a previously allocated video surface */
 	void (*FreeHWSurface)(_THIS, SDL_Surface *surface);
 
+	/* Sets the number of vertical blanks to wait for, -1 for adaptive */
+	int (*SetSwapInterval)(_THIS, int interval);
+
+	/* Returns presentation timing statistics */
+	int (*GetPresentStats)(_THIS, SDL_PresentStats *stats);
+
 	/* * * */
 	/* Gamma support */
 
@@ -222,6 +231,24 @@ struct SDL_VideoDevice {
 #if SDL_VIDEO_OPENGL | SDL_VIDEO_OPENGL_ES
 	/* Texture id */
 	GLuint texture;
+	/* Texture size, covers the whole screen unless GL can't do that */
+	int texture_w;
+	int texture_h;
+#if SDL_VIDEO_OPENGL_ES
+	/* Application state SDL_GL_Lock() replaced for GLES, put back on unlock */
+	struct {
+		Uint32 caps;
+		Uint32 changed;
+		GLint matrix_mode;
+		GLint texture;
+		GLint tex_env;
+		GLint alignment;
+		GLint blend_src;
+		GLint blend_dst;
+		GLint viewport[4];
+		GLfloat color[4];
+	} gl_state;
+#endif
 #endif
 	int is_32bit;
  
@@ -304,6 +331,8 @@ struct SDL_VideoDevice {
 	int handles_any_size;	/* Driver handles any size video mode */
 	int can_select;			/* This driver supports a select() event loop. */
 	int monitor_fd;			/* FD to monitor if select event loop is available. */
+	int stretch_blit;		/* hw_blit scales when the rects differ in size */
+	SDL_StretchFilter stretch_filter;	/* Filter for the hw_blit of SDL_StretchBlit() */
 
 	/* * * */
 	/* Data used by the GL drivers */
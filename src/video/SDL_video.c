@@ -143,6 +143,9 @@ static SDL_GrabMode SDL_WM_GrabInputOff(void);
 #if SDL_VIDEO_OPENGL || SDL_VIDEO_OPENGL_ES
 static int lock_count = 0;
 #endif
+#if SDL_VIDEO_OPENGL
+static int power_of_two(int input);
+#endif
 
 
 /*
@@ -884,14 +887,28 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 
 		/* Set the surface completely opaque & white by default */
 		SDL_memset( SDL_VideoSurface->pixels, 255, SDL_VideoSurface->h * SDL_VideoSurface->pitch );
+
+		/* One texture for the whole screen, so each rect is uploaded once */
+		{
+			GLint max_size = 256;
+			video->glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_size );
+			video->texture_w = power_of_two(width);
+			video->texture_h = power_of_two(height);
+			if ( video->texture_w > max_size ) {
+				video->texture_w = max_size;
+			}
+			if ( video->texture_h > max_size ) {
+				video->texture_h = max_size;
+			}
+		}
 		video->glGenTextures( 1, &video->texture );
 		video->glBindTexture( GL_TEXTURE_2D, video->texture );
 		video->glTexImage2D(
 			GL_TEXTURE_2D,
 			0,
 			video->is_32bit ? GL_RGBA : GL_RGB,
-			256,
-			256,
+			video->texture_w,
+			video->texture_h,
 			0,
 			video->is_32bit ? GL_RGBA : GL_RGB,
 #ifdef GL_VERSION_1_2
@@ -900,6 +917,11 @@ SDL_Surface * SDL_SetVideoMode (int width, int height, int bpp, Uint32 flags)
 			GL_UNSIGNED_BYTE,
 #endif
 			NULL);
+		/* Filtering is texture object state, nobody else touches it */
+		video->glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+		video->glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+		video->glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+		video->glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
 
 		video->UpdateRects = SDL_GL_UpdateRectsLock;
 #else
@@ -1173,6 +1195,34 @@ int SDL_Flip(SDL_Surface *screen)
 	return(0);
 }
 
+int SDL_SetSwapInterval(int interval)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+
+	if ( interval < -1 ) {
+		SDL_SetError("Invalid swap interval");
+		return(-1);
+	}
+	if ( video && video->SetSwapInterval ) {
+		return(video->SetSwapInterval(this, interval));
+	}
+	SDL_SetError("Swap interval control not supported");
+	return(-1);
+}
+
+int SDL_GetPresentStats(SDL_PresentStats *stats)
+{
+	SDL_VideoDevice *video = current_video;
+	SDL_VideoDevice *this  = current_video;
+
+	if ( video && video->GetPresentStats ) {
+		return(video->GetPresentStats(this, stats));
+	}
+	SDL_SetError("Present statistics not supported");
+	return(-1);
+}
+
 static void SetPalette_logical(SDL_Surface *screen, SDL_Color *colors,
 			       int firstcolor, int ncolors)
 {
@@ -1620,80 +1670,278 @@ void SDL_GL_UpdateRectsLock(SDL_VideoDevice* this, int numrects, SDL_Rect *rects
 	SDL_GL_Unlock();
 }
 
-/* Update rects without state setting and changing (the caller is responsible for it) */
+#if SDL_VIDEO_OPENGL
+static int power_of_two(int input)
+{
+	int value = 1;
+
+	while ( value < input ) {
+		value <<= 1;
+	}
+	return value;
+}
+
+/* Two triangles covering 'area' of the screen, sampled at texture 'tx,ty' */
+static void SDL_GL_AddQuad(SDL_VideoDevice *this, GLfloat *v, GLfloat *t,
+                           const SDL_Rect *area, int tx, int ty)
+{
+	GLfloat x1 = area->x, y1 = area->y;
+	GLfloat x2 = x1 + area->w, y2 = y1 + area->h;
+	GLfloat s1 = (GLfloat)tx / this->texture_w;
+	GLfloat t1 = (GLfloat)ty / this->texture_h;
+	GLfloat s2 = (GLfloat)(tx + area->w) / this->texture_w;
+	GLfloat t2 = (GLfloat)(ty + area->h) / this->texture_h;
+
+	v[0] = x1; v[1] = y1;   t[0] = s1; t[1] = t1;
+	v[2] = x2; v[3] = y1;   t[2] = s2; t[3] = t1;
+	v[4] = x1; v[5] = y2;   t[4] = s1; t[5] = t2;
+	v[6] = x2; v[7] = y1;   t[6] = s2; t[7] = t1;
+	v[8] = x2; v[9] = y2;   t[8] = s2; t[9] = t2;
+	v[10] = x1; v[11] = y2; t[10] = s1; t[11] = t2;
+}
+
+/* Quads drawn per glDrawArrays(), rects beyond that start a new batch */
+#define GL_QUAD_BATCH	64
+
+static void SDL_GL_DrawQuads(SDL_VideoDevice *this, GLfloat *v, GLfloat *t, int count)
+{
+	this->glVertexPointer(2, GL_FLOAT, 0, v);
+	this->glTexCoordPointer(2, GL_FLOAT, 0, t);
+	this->glDrawArrays(GL_TRIANGLES, 0, count * 6);
+}
+#endif /* SDL_VIDEO_OPENGL */
+
+/*
+ * Update rects without state setting and changing (the caller is responsible for it).
+ * The vertex and texture coordinate arrays are the exception, they are
+ * saved and restored around the draw.
+ */
 void SDL_GL_UpdateRects(int numrects, SDL_Rect *rects)
 {
 #if SDL_VIDEO_OPENGL
 	SDL_VideoDevice *this = current_video;
-	SDL_Rect update, tmp;
-	int x, y, i;
-
-	for ( i = 0; i < numrects; i++ )
-	{
-		tmp.y = rects[i].y;
-		tmp.h = rects[i].h;
-		for ( y = 0; y <= rects[i].h / 256; y++ )
-		{
-			tmp.x = rects[i].x;
-			tmp.w = rects[i].w;
-			for ( x = 0; x <= rects[i].w / 256; x++ )
-			{
-				update.x = tmp.x;
-				update.y = tmp.y;
-				update.w = tmp.w;
-				update.h = tmp.h;
-
-				if ( update.w > 256 )
-					update.w = 256;
-
-				if ( update.h > 256 )
-					update.h = 256;
-			
-				this->glFlush();
-				this->glTexSubImage2D( 
-					GL_TEXTURE_2D, 
-					0, 
-					0, 
-					0, 
-					update.w, 
-					update.h, 
-					this->is_32bit? GL_RGBA : GL_RGB,
+	SDL_Surface *screen = this->screen;
+	GLenum format = this->is_32bit ? GL_RGBA : GL_RGB;
 #ifdef GL_VERSION_1_2
-					this->is_32bit ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT_5_6_5,
+	GLenum type = this->is_32bit ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT_5_6_5;
 #else
-					GL_UNSIGNED_BYTE,
+	GLenum type = GL_UNSIGNED_BYTE;
 #endif
-					(Uint8 *)this->screen->pixels + 
-						this->screen->format->BytesPerPixel * update.x + 
-						update.y * this->screen->pitch );
-	
-				this->glFlush();
-				/*
-				* Note the parens around the function name:
-				* This is because some OpenGL implementations define glTexCoord etc 
-				* as macros, and we don't want them expanded here.
-				*/
-				this->glBegin(GL_TRIANGLE_STRIP);
-					(this->glTexCoord2f)( 0.0, 0.0 );	
-					(this->glVertex2i)( update.x, update.y );
-					(this->glTexCoord2f)( (float)(update.w / 256.0), 0.0 );	
-					(this->glVertex2i)( update.x + update.w, update.y );
-					(this->glTexCoord2f)( 0.0, (float)(update.h / 256.0) );
-					(this->glVertex2i)( update.x, update.y + update.h );
-					(this->glTexCoord2f)( (float)(update.w / 256.0), (float)(update.h / 256.0) );	
-					(this->glVertex2i)( update.x + update.w	, update.y + update.h );
-				this->glEnd();	
-			
-				tmp.x += 256;
-				tmp.w -= 256;
+	int bpp = screen->format->BytesPerPixel;
+	SDL_Rect update;
+	GLfloat verts[GL_QUAD_BATCH * 12], texcoords[GL_QUAD_BATCH * 12];
+	int x, y, i, n;
+
+	if ( numrects <= 0 ) {
+		return;
+	}
+
+#ifdef GL_CLIENT_VERTEX_ARRAY_BIT
+	this->glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+#endif
+	this->glEnableClientState(GL_VERTEX_ARRAY);
+	this->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	/*
+	 * GL_UNPACK_ROW_LENGTH is the surface pitch (set by SDL_GL_Lock),
+	 * so each rect is uploaded straight from the surface.
+	 */
+	if ( screen->w <= this->texture_w && screen->h <= this->texture_h ) {
+		/* Every rect lands at its own place, then one draw per batch */
+		n = 0;
+		for ( i = 0; i < numrects; i++ ) {
+			if ( !rects[i].w || !rects[i].h ) {
+				continue;
+			}
+			this->glTexSubImage2D(GL_TEXTURE_2D, 0,
+				rects[i].x, rects[i].y, rects[i].w, rects[i].h,
+				format, type,
+				(Uint8 *)screen->pixels +
+					rects[i].y * screen->pitch + rects[i].x * bpp);
+			SDL_GL_AddQuad(this, verts + n * 12, texcoords + n * 12,
+			               &rects[i], rects[i].x, rects[i].y);
+			if ( ++n == GL_QUAD_BATCH ) {
+				SDL_GL_DrawQuads(this, verts, texcoords, n);
+				n = 0;
+			}
+		}
+		if ( n ) {
+			SDL_GL_DrawQuads(this, verts, texcoords, n);
+		}
+	} else {
+		/* Screen larger than the biggest texture, go through it in tiles */
+		for ( i = 0; i < numrects; i++ ) {
+			for ( y = 0; y < rects[i].h; y += this->texture_h ) {
+				for ( x = 0; x < rects[i].w; x += this->texture_w ) {
+					update.x = rects[i].x + x;
+					update.y = rects[i].y + y;
+					update.w = rects[i].w - x;
+					update.h = rects[i].h - y;
+					if ( update.w > this->texture_w ) {
+						update.w = this->texture_w;
+					}
+					if ( update.h > this->texture_h ) {
+						update.h = this->texture_h;
+					}
+
+					this->glTexSubImage2D(GL_TEXTURE_2D, 0,
+						0, 0, update.w, update.h,
+						format, type,
+						(Uint8 *)screen->pixels +
+							update.y * screen->pitch + update.x * bpp);
+					SDL_GL_AddQuad(this, verts, texcoords, &update, 0, 0);
+					SDL_GL_DrawQuads(this, verts, texcoords, 1);
+				}
 			}
-			tmp.y += 256;
-			tmp.h -= 256;
 		}
 	}
+
+#ifdef GL_CLIENT_VERTEX_ARRAY_BIT
+	this->glPopClientAttrib();
+#else
+	this->glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	this->glDisableClientState(GL_VERTEX_ARRAY);
 #endif
+#endif
+}
+
+#if SDL_VIDEO_OPENGL | SDL_VIDEO_OPENGL_ES
+/* Capabilities the blit needs on (1) or off (0) */
+static const struct {
+	GLenum cap;
+	int on;
+} gl_lock_caps[] = {
+	{ GL_TEXTURE_2D, 1 },
+	{ GL_BLEND, 1 },
+	{ GL_FOG, 0 },
+	{ GL_ALPHA_TEST, 0 },
+	{ GL_DEPTH_TEST, 0 },
+	{ GL_SCISSOR_TEST, 0 },
+	{ GL_STENCIL_TEST, 0 },
+	{ GL_CULL_FACE, 0 },
+};
+#endif /* SDL_VIDEO_OPENGL | SDL_VIDEO_OPENGL_ES */
+
+#if SDL_VIDEO_OPENGL_ES
+#define GL_STATE_TEXTURE	0x01
+#define GL_STATE_TEX_ENV	0x02
+#define GL_STATE_ALIGNMENT	0x04
+#define GL_STATE_BLEND		0x08
+#define GL_STATE_VIEWPORT	0x10
+#define GL_STATE_COLOR		0x20
+
+/*
+ * GLES has no attribute stack, so read back the state the blit depends
+ * on and only change what differs.  The application may draw between
+ * updates, so this is done on every lock.
+ */
+static void SDL_GLES_SaveState(SDL_VideoDevice *this)
+{
+	int i, on;
+	int w = this->screen->w, h = this->screen->h;
+
+	this->gl_state.caps = 0;
+	this->gl_state.changed = 0;
+	for ( i = 0; i < SDL_arraysize(gl_lock_caps); i++ ) {
+		on = this->GLES_glIsEnabled(gl_lock_caps[i].cap) ? 1 : 0;
+		if ( on ) {
+			this->gl_state.caps |= (1 << i);
+		}
+		if ( on != gl_lock_caps[i].on ) {
+			if ( gl_lock_caps[i].on ) {
+				this->GLES_glEnable(gl_lock_caps[i].cap);
+			} else {
+				this->GLES_glDisable(gl_lock_caps[i].cap);
+			}
+		}
+	}
+
+	this->GLES_glGetIntegerv(GL_TEXTURE_BINDING_2D, &this->gl_state.texture);
+	if ( this->gl_state.texture != (GLint)this->texture ) {
+		this->GLES_glBindTexture(GL_TEXTURE_2D, this->texture);
+		this->gl_state.changed |= GL_STATE_TEXTURE;
+	}
+
+	this->GLES_glGetTexEnviv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, &this->gl_state.tex_env);
+	if ( this->gl_state.tex_env != GL_MODULATE ) {
+		this->GLES_glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		this->gl_state.changed |= GL_STATE_TEX_ENV;
+	}
+
+	this->GLES_glGetIntegerv(GL_UNPACK_ALIGNMENT, &this->gl_state.alignment);
+	if ( this->gl_state.alignment != 4 ) {
+		this->GLES_glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		this->gl_state.changed |= GL_STATE_ALIGNMENT;
+	}
+
+	this->GLES_glGetIntegerv(GL_BLEND_SRC, &this->gl_state.blend_src);
+	this->GLES_glGetIntegerv(GL_BLEND_DST, &this->gl_state.blend_dst);
+	if ( this->gl_state.blend_src != GL_SRC_ALPHA ||
+	     this->gl_state.blend_dst != GL_ONE_MINUS_SRC_ALPHA ) {
+		this->GLES_glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		this->gl_state.changed |= GL_STATE_BLEND;
+	}
+
+	this->GLES_glGetFloatv(GL_CURRENT_COLOR, this->gl_state.color);
+	if ( this->gl_state.color[0] != 1.0f || this->gl_state.color[1] != 1.0f ||
+	     this->gl_state.color[2] != 1.0f || this->gl_state.color[3] != 1.0f ) {
+		/* Note the parens, glColor4f may be a macro (Solaris) */
+		(this->GLES_glColor4f)(1.0, 1.0, 1.0, 1.0);
+		this->gl_state.changed |= GL_STATE_COLOR;
+	}
+
+	this->GLES_glGetIntegerv(GL_VIEWPORT, this->gl_state.viewport);
+	if ( this->gl_state.viewport[0] != 0 || this->gl_state.viewport[1] != 0 ||
+	     this->gl_state.viewport[2] != w || this->gl_state.viewport[3] != h ) {
+		this->GLES_glViewport(0, 0, w, h);
+		this->gl_state.changed |= GL_STATE_VIEWPORT;
+	}
+
+	this->GLES_glGetIntegerv(GL_MATRIX_MODE, &this->gl_state.matrix_mode);
 }
 
+/* Put back whatever SDL_GLES_SaveState() had to change */
+static void SDL_GLES_RestoreState(SDL_VideoDevice *this)
+{
+	Uint32 changed = this->gl_state.changed;
+	int i, on;
+
+	for ( i = 0; i < SDL_arraysize(gl_lock_caps); i++ ) {
+		on = (this->gl_state.caps & (1 << i)) ? 1 : 0;
+		if ( on != gl_lock_caps[i].on ) {
+			if ( on ) {
+				this->GLES_glEnable(gl_lock_caps[i].cap);
+			} else {
+				this->GLES_glDisable(gl_lock_caps[i].cap);
+			}
+		}
+	}
+	if ( changed & GL_STATE_TEXTURE ) {
+		this->GLES_glBindTexture(GL_TEXTURE_2D, this->gl_state.texture);
+	}
+	if ( changed & GL_STATE_TEX_ENV ) {
+		this->GLES_glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, this->gl_state.tex_env);
+	}
+	if ( changed & GL_STATE_ALIGNMENT ) {
+		this->GLES_glPixelStorei(GL_UNPACK_ALIGNMENT, this->gl_state.alignment);
+	}
+	if ( changed & GL_STATE_BLEND ) {
+		this->GLES_glBlendFunc(this->gl_state.blend_src, this->gl_state.blend_dst);
+	}
+	if ( changed & GL_STATE_COLOR ) {
+		(this->GLES_glColor4f)(this->gl_state.color[0], this->gl_state.color[1],
+		                       this->gl_state.color[2], this->gl_state.color[3]);
+	}
+	if ( changed & GL_STATE_VIEWPORT ) {
+		this->GLES_glViewport(this->gl_state.viewport[0], this->gl_state.viewport[1],
+		                      this->gl_state.viewport[2], this->gl_state.viewport[3]);
+	}
+	if ( this->gl_state.matrix_mode != GL_MODELVIEW ) {
+		this->GLES_glMatrixMode(this->gl_state.matrix_mode);
+	}
+}
+#endif /* SDL_VIDEO_OPENGL_ES */
+
 /* Lock == save current state */
 void SDL_GL_Lock()
 {
@@ -1706,32 +1954,17 @@ void SDL_GL_Lock()
 #if SDL_VIDEO_OPENGL_ES
 		if (this->screen->flags & SDL_OPENGLES)
 		{
-			this->GLES_glEnable(GL_TEXTURE_2D);
-			this->GLES_glEnable(GL_BLEND);
-			this->GLES_glDisable(GL_FOG);
-			this->GLES_glDisable(GL_ALPHA_TEST);
-			this->GLES_glDisable(GL_DEPTH_TEST);
-			this->GLES_glDisable(GL_SCISSOR_TEST);
-			this->GLES_glDisable(GL_STENCIL_TEST);
-			this->GLES_glDisable(GL_CULL_FACE);
-
-			this->GLES_glBindTexture( GL_TEXTURE_2D, this->texture );
-			this->GLES_glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
-			this->GLES_glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-			this->GLES_glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-			this->GLES_glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-			this->GLES_glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-
-			this->GLES_glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
-			this->GLES_glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-			(this->GLES_glColor4f)(1.0, 1.0, 1.0, 1.0);               /* Solaris workaround */
-
-			this->GLES_glViewport(0, 0, this->screen->w, this->screen->h);
+			SDL_GLES_SaveState(this);
+
 			this->GLES_glMatrixMode(GL_PROJECTION);
 			this->GLES_glPushMatrix();
 			this->GLES_glLoadIdentity();
 
 			this->GLES_glOrthof(0.0, this->screen->w, this->screen->h, 0.0, 0.0, 1.0);
+
+			this->GLES_glMatrixMode(GL_MODELVIEW);
+			this->GLES_glPushMatrix();
+			this->GLES_glLoadIdentity();
 		}
 #endif /* SDL_VIDEO_OPENGL_ES */
 #if SDL_VIDEO_OPENGL & SDL_VIDEO_OPENGL_ES
@@ -1739,27 +1972,32 @@ void SDL_GL_Lock()
 #endif
 #if SDL_VIDEO_OPENGL
 		{
-			this->glPushAttrib( GL_ALL_ATTRIB_BITS );	/* TODO: narrow range of what is saved */
+			int i;
+
+			/*
+			 * Only the groups the blit touches, a push is server side
+			 * and doesn't wait on the pipeline like glGet does.  The
+			 * texture object's own parameters were set in SDL_SetVideoMode().
+			 */
+			this->glPushAttrib( GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT |
+			                    GL_VIEWPORT_BIT | GL_TEXTURE_BIT |
+			                    GL_CURRENT_BIT | GL_TRANSFORM_BIT );
 #ifdef GL_CLIENT_PIXEL_STORE_BIT
-			this->glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT );
+			this->glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT | GL_CLIENT_VERTEX_ARRAY_BIT );
 #endif
 
-			this->glEnable(GL_TEXTURE_2D);
-			this->glEnable(GL_BLEND);
-			this->glDisable(GL_FOG);
-			this->glDisable(GL_ALPHA_TEST);
-			this->glDisable(GL_DEPTH_TEST);
-			this->glDisable(GL_SCISSOR_TEST);
-			this->glDisable(GL_STENCIL_TEST);
-			this->glDisable(GL_CULL_FACE);
+			for ( i = 0; i < SDL_arraysize(gl_lock_caps); i++ ) {
+				if ( gl_lock_caps[i].on ) {
+					this->glEnable(gl_lock_caps[i].cap);
+				} else {
+					this->glDisable(gl_lock_caps[i].cap);
+				}
+			}
 
 			this->glBindTexture( GL_TEXTURE_2D, this->texture );
 			this->glTexEnvf( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
-			this->glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-			this->glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-			this->glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-			this->glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
 
+			this->glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
 			this->glPixelStorei( GL_UNPACK_ROW_LENGTH, this->screen->pitch / this->screen->format->BytesPerPixel );
 			this->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 			(this->glColor4f)(1.0, 1.0, 1.0, 1.0);		/* Solaris workaround */
@@ -1795,11 +2033,9 @@ void SDL_GL_Unlock()
 			this->GLES_glPopMatrix();
 			this->GLES_glMatrixMode(GL_PROJECTION);
 			this->GLES_glPopMatrix();
+			this->GLES_glMatrixMode(GL_MODELVIEW);
 
-			this->GLES_glDisable(GL_TEXTURE_2D);
-			this->GLES_glDisable(GL_BLEND);
-			this->GLES_glEnable(GL_DEPTH_TEST);
-			this->GLES_glEnable(GL_CULL_FACE);
+			SDL_GLES_RestoreState(this);
 		}
 #endif /* SDL_VIDEO_OPENGL_ES */
 #if SDL_VIDEO_OPENGL & SDL_VIDEO_OPENGL_ES
@@ -1811,7 +2047,9 @@ void SDL_GL_Unlock()
 			this->glMatrixMode(GL_PROJECTION);
 			this->glPopMatrix();
 
+#ifdef GL_CLIENT_PIXEL_STORE_BIT
 			this->glPopClientAttrib();
+#endif
 			this->glPopAttrib();
 		}
 #endif
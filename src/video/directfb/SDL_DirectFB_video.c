@@ -120,6 +120,9 @@ static SDL_VideoDevice *DirectFB_CreateDevice(int devindex)
     }
   SDL_memset (device->hidden, 0, sizeof (*device->hidden));
 
+  /* Set the driver flags */
+  device->stretch_blit = 1;
+
   /* Set the function pointers */
   device->VideoInit = DirectFB_VideoInit;
   device->ListModes = DirectFB_ListModes;
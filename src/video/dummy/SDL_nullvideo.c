@@ -31,6 +31,10 @@
  *  is a performance problem for a given platform, enable this driver, and
  *  then see if your application runs faster without video overhead.
  *
+ * For headless testing it can also report how much of the screen each frame
+ *  updates and dump frames (or just their hashes) to disk, see
+ *  DUMMY_VideoInit() for the environment variables.
+ *
  * Initial work by Ryan C. Gordon (icculus@icculus.org). A good portion
  *  of this was cut-and-pasted from Stephane Peter's work in the AAlib
  *  SDL video driver.  Renamed to "DUMMY" by Sam Lantinga.
@@ -78,6 +82,7 @@ static int DUMMY_Available(void)
 
 static void DUMMY_DeleteDevice(SDL_VideoDevice *device)
 {
+	SDL_free(device->hidden->dump_dir);
 	SDL_free(device->hidden);
 	SDL_free(device);
 }
@@ -138,8 +143,19 @@ VideoBootStrap DUMMY_bootstrap = {
 };
 
 
+/*
+ * Environment:
+ *   SDL_VIDEO_DUMMY_BPP            depth used when the application asks for 0
+ *   SDL_VIDEO_DUMMY_STATS=N        print update statistics every N frames
+ *   SDL_VIDEO_DUMMY_DUMP=dir       save frames as dir/frameNNNNNN.bmp
+ *   SDL_VIDEO_DUMMY_HASH=file      write "frame hash" lines to file
+ *   SDL_VIDEO_DUMMY_DUMP_INTERVAL  dump or hash every Nth frame (default 1)
+ */
 int DUMMY_VideoInit(_THIS, SDL_PixelFormat *vformat)
 {
+	const char *env;
+	int bpp;
+
 	/*
 	fprintf(stderr, "WARNING: You are using the SDL dummy video driver!\n");
 	*/
@@ -149,6 +165,36 @@ int DUMMY_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	vformat->BitsPerPixel = 8;
 	vformat->BytesPerPixel = 1;
 
+	/* Any depth works natively, pick the one the application should get */
+	env = SDL_getenv("SDL_VIDEO_DUMMY_BPP");
+	bpp = env ? SDL_atoi(env) : 0;
+	if ( bpp == 15 || bpp == 16 || bpp == 24 || bpp == 32 ) {
+		vformat->BitsPerPixel = bpp;
+		vformat->BytesPerPixel = (bpp + 7) / 8;
+	}
+
+	env = SDL_getenv("SDL_VIDEO_DUMMY_STATS");
+	this->hidden->stats_every = env ? SDL_atoi(env) : 0;
+
+	env = SDL_getenv("SDL_VIDEO_DUMMY_DUMP_INTERVAL");
+	this->hidden->dump_every = env ? SDL_atoi(env) : 1;
+	if ( this->hidden->dump_every < 1 ) {
+		this->hidden->dump_every = 1;
+	}
+
+	env = SDL_getenv("SDL_VIDEO_DUMMY_DUMP");
+	if ( env && *env ) {
+		this->hidden->dump_dir = SDL_strdup(env);
+	}
+
+	env = SDL_getenv("SDL_VIDEO_DUMMY_HASH");
+	if ( env && *env ) {
+		this->hidden->hash_file = SDL_RWFromFile(env, "w");
+		if ( ! this->hidden->hash_file ) {
+			return(-1);
+		}
+	}
+
 	/* We're done! */
 	return(0);
 }
@@ -158,36 +204,58 @@ SDL_Rect **DUMMY_ListModes(_THIS, SDL_PixelFormat *format, Uint32 flags)
    	 return (SDL_Rect **) -1;
 }
 
+static void DUMMY_PrintStats(_THIS)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	Uint32 frames = hidden->frames;
+	Uint32 screen_area = hidden->w * hidden->h;
+
+	if ( ! frames || ! screen_area ) {
+		return;
+	}
+	fprintf(stderr, "SDL dummy: %dx%d, %u frames, %u rects/frame, "
+		"%u pixels/frame (%u%% of the screen)\n",
+		hidden->w, hidden->h, frames, hidden->rects / frames,
+		(Uint32)(hidden->area / frames),
+		(Uint32)(hidden->area * 100 / ((double)screen_area * frames)));
+}
+
 SDL_Surface *DUMMY_SetVideoMode(_THIS, SDL_Surface *current,
 				int width, int height, int bpp, Uint32 flags)
 {
-	if ( this->hidden->buffer ) {
-		SDL_free( this->hidden->buffer );
+	if ( this->hidden->stats_every ) {
+		DUMMY_PrintStats(this);
 	}
+	this->hidden->frames = 0;
+	this->hidden->rects = 0;
+	this->hidden->area = 0;
 
-	this->hidden->buffer = SDL_malloc(width * height * (bpp / 8));
-	if ( ! this->hidden->buffer ) {
-		SDL_SetError("Couldn't allocate buffer for requested mode");
-		return(NULL);
+	if ( this->hidden->buffer ) {
+		SDL_free( this->hidden->buffer );
+		this->hidden->buffer = NULL;
 	}
 
-/* 	printf("Setting mode %dx%d\n", width, height); */
-
-	SDL_memset(this->hidden->buffer, 0, width * height * (bpp / 8));
-
 	/* Allocate the new pixel format for the screen */
 	if ( ! SDL_ReallocFormat(current, bpp, 0, 0, 0, 0) ) {
-		SDL_free(this->hidden->buffer);
-		this->hidden->buffer = NULL;
 		SDL_SetError("Couldn't allocate new pixel format for requested mode");
 		return(NULL);
 	}
 
-	/* Set up the new mode framebuffer */
+	/* Set up the new mode framebuffer, 15 bpp needs two bytes too */
 	current->flags = flags & SDL_FULLSCREEN;
 	this->hidden->w = current->w = width;
 	this->hidden->h = current->h = height;
-	current->pitch = current->w * (bpp / 8);
+	current->pitch = SDL_CalculatePitch(current);
+
+	this->hidden->buffer = SDL_malloc(height * current->pitch);
+	if ( ! this->hidden->buffer ) {
+		SDL_SetError("Couldn't allocate buffer for requested mode");
+		return(NULL);
+	}
+
+/* 	printf("Setting mode %dx%d\n", width, height); */
+
+	SDL_memset(this->hidden->buffer, 0, height * current->pitch);
 	current->pixels = this->hidden->buffer;
 
 	/* We're done */
@@ -215,9 +283,73 @@ static void DUMMY_UnlockHWSurface(_THIS, SDL_Surface *surface)
 	return;
 }
 
+/* FNV-1a over the visible pixels, pitch padding left out */
+static Uint32 DUMMY_HashFrame(SDL_Surface *screen)
+{
+	Uint32 hash = 2166136261u;
+	int len = screen->w * screen->format->BytesPerPixel;
+	int x, y;
+
+	for ( y = 0; y < screen->h; ++y ) {
+		const Uint8 *row = (const Uint8 *)screen->pixels + y * screen->pitch;
+		for ( x = 0; x < len; ++x ) {
+			hash = (hash ^ row[x]) * 16777619u;
+		}
+	}
+	return(hash);
+}
+
+static void DUMMY_DumpFrame(_THIS, Uint32 frame)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	char buf[64];
+	char *path;
+	size_t len;
+
+	if ( hidden->hash_file ) {
+		SDL_snprintf(buf, sizeof(buf), "%u %08x\n",
+		             frame, DUMMY_HashFrame(this->screen));
+		SDL_RWwrite(hidden->hash_file, buf, SDL_strlen(buf), 1);
+	}
+
+	if ( hidden->dump_dir ) {
+		len = SDL_strlen(hidden->dump_dir) + 32;
+		path = SDL_stack_alloc(char, len);
+		if ( ! path ) {
+			return;
+		}
+		SDL_snprintf(path, len, "%s/frame%06u.bmp", hidden->dump_dir, frame);
+		SDL_SaveBMP(this->screen, path);
+		SDL_stack_free(path);
+	}
+}
+
 static void DUMMY_UpdateRects(_THIS, int numrects, SDL_Rect *rects)
 {
-	/* do nothing. */
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	Uint32 frame;
+	int i;
+
+	/* No mode set yet */
+	if ( ! hidden->buffer ) {
+		return;
+	}
+	frame = hidden->frames++;
+
+	/* Nothing is displayed, just account for what would have been */
+	for ( i = 0; i < numrects; ++i ) {
+		hidden->area += (double)rects[i].w * rects[i].h;
+	}
+	hidden->rects += numrects;
+
+	if ( hidden->stats_every && (hidden->frames % hidden->stats_every) == 0 ) {
+		DUMMY_PrintStats(this);
+	}
+
+	if ( (hidden->dump_dir || hidden->hash_file) &&
+	     (frame % hidden->dump_every) == 0 ) {
+		DUMMY_DumpFrame(this, frame);
+	}
 }
 
 int DUMMY_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
@@ -231,6 +363,14 @@ int DUMMY_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 */
 void DUMMY_VideoQuit(_THIS)
 {
+	if ( this->hidden->stats_every ) {
+		DUMMY_PrintStats(this);
+	}
+	if ( this->hidden->hash_file ) {
+		SDL_RWclose(this->hidden->hash_file);
+		this->hidden->hash_file = NULL;
+	}
+
 	if (this->screen->pixels != NULL)
 	{
 		SDL_free(this->screen->pixels);
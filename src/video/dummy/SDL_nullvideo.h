@@ -35,6 +35,17 @@
 struct SDL_PrivateVideoData {
     int w, h;
     void *buffer;
+
+    /* Per-mode update statistics, SDL_VIDEO_DUMMY_STATS=N prints every N frames */
+    int stats_every;
+    Uint32 frames;
+    Uint32 rects;
+    double area;	/* in pixels, summed over frames */
+
+    /* Frame dumps, every dump_every frames */
+    int dump_every;
+    char *dump_dir;	/* SDL_VIDEO_DUMMY_DUMP, one BMP per frame */
+    SDL_RWops *hash_file;	/* SDL_VIDEO_DUMMY_HASH, one line per frame */
 };
 
 #endif /* _SDL_nullvideo_h */
@@ -33,5 +33,6 @@ SDL_X11_ATOM(_NET_WM_STATE_FULLSCREEN, "_NET_WM_STATE_FULLSCREEN")
 SDL_X11_ATOM(AbsMTTrackingID, "Abs MT Tracking ID")
 SDL_X11_ATOM(AbsMTPositionX, "Abs MT Position X")
 SDL_X11_ATOM(AbsMTPositionY, "Abs MT Position Y")
+SDL_X11_ATOM(AbsMTPressure, "Abs MT Pressure")
 #endif /* SDL_VIDEO_DRIVER_X11_XINPUT2 */
 
@@ -396,13 +396,15 @@ static __inline__ int X11_WarpedMotion(_THIS, XEvent *xevent)
 #if SDL_VIDEO_DRIVER_X11_XINPUT2
 int X11_XInput2_SetMasterPointer(_THIS, int deviceid)
 {
-	int device_count = 0, i;
+	int device_count = 0, i, n;
 	if (xi_master) {
 		XIFreeDeviceInfo(xi_master);
 		xi_master = NULL;
 	}
 
 	have_touch = 0;
+	xi_touch.count = 0;
+	xi_touch.valid = 0;
 
 	xi_master = XIQueryDevice(SDL_Display, deviceid, &device_count);
 	if (!xi_master) {
@@ -410,97 +412,155 @@ int X11_XInput2_SetMasterPointer(_THIS, int deviceid)
 		return -1;
 	}
 
+	/* Each contact point is a position X, position Y and tracking ID
+	 * valuator, the tracking ID always coming last. */
+	n = 0;
+	xi_touch.contact[0].x = -1;
+	xi_touch.contact[0].y = -1;
+	xi_touch.contact[0].pressure = -1;
 	for (i = 0; i < xi_master->num_classes; i++) {
 		if (xi_master->classes[i]->type == XIValuatorClass) {
 			XIValuatorClassInfo *valuator = (XIValuatorClassInfo*)(xi_master->classes[i]);
-			if (valuator->label == atom(AbsMTTrackingID)) {
-				have_touch = 1;
+			if (n == SDL_arraysize(xi_touch.contact)) {
 				break;
 			}
+			if (valuator->label == atom(AbsMTPositionX)) {
+				xi_touch.contact[n].x = valuator->number;
+				xi_touch.contact[n].min_x = valuator->min;
+				xi_touch.contact[n].range_x = valuator->max - valuator->min;
+			} else if (valuator->label == atom(AbsMTPositionY)) {
+				xi_touch.contact[n].y = valuator->number;
+				xi_touch.contact[n].min_y = valuator->min;
+				xi_touch.contact[n].range_y = valuator->max - valuator->min;
+			} else if (valuator->label == atom(AbsMTPressure)) {
+				xi_touch.contact[n].pressure = valuator->number;
+				xi_touch.contact[n].min_pressure = valuator->min;
+				xi_touch.contact[n].range_pressure = valuator->max - valuator->min;
+			} else if (valuator->label == atom(AbsMTTrackingID)) {
+				xi_touch.contact[n].id = valuator->number;
+				have_touch = 1;
+				n++;
+				/* Positions not given for the next contact are missing */
+				if (n < SDL_arraysize(xi_touch.contact)) {
+					xi_touch.contact[n].x = -1;
+					xi_touch.contact[n].y = -1;
+					xi_touch.contact[n].pressure = -1;
+				}
+			}
 		}
 	}
+	xi_touch.count = n;
 
 	return 0;
 }
 
-static inline void X11_XInput2_ClipTouch(Sint16* val, int min, int size)
+/* Fold the display size, window position and X11_ScaleInput() into one
+ * fixed-point transform per axis, redone after xi_touch.valid is cleared. */
+static void X11_XInput2_UpdateTouchMap(_THIS)
 {
-	if (*val < min || *val >= (min + size)) {
-		*val = -1;
-	} else {
-		*val -= min;
+	const int screen_w = DisplayWidth(SDL_Display, SDL_Screen);
+	const int screen_h = DisplayHeight(SDL_Display, SDL_Screen);
+	int view_x, view_y, view_w, view_h;
+	Uint32 scale_x, scale_y;
+	int i;
+
+	xi_touch.valid = 1;
+
+	for (i = 0; i < xi_touch.count; i++) {
+		int rx = xi_touch.contact[i].range_x;
+		int ry = xi_touch.contact[i].range_y;
+		xi_touch.contact[i].scale_x = rx > 0 ? ((Uint32)screen_w << 16) / rx : 0;
+		xi_touch.contact[i].scale_y = ry > 0 ? ((Uint32)screen_h << 16) / ry : 0;
 	}
+
+	/* Display pixels are clipped to the window, then to the view */
+	X11_GetInputView(this, &view_x, &view_y, &view_w, &view_h,
+			 &scale_x, &scale_y);
+	xi_touch.axis[0].origin = window_x + view_x;
+	xi_touch.axis[0].lo = SDL_max(0, -view_x);
+	xi_touch.axis[0].hi = SDL_min(window_w - view_x, view_w);
+	xi_touch.axis[0].scale = scale_x;
+	xi_touch.axis[1].origin = window_y + view_y;
+	xi_touch.axis[1].lo = SDL_max(0, -view_y);
+	xi_touch.axis[1].hi = SDL_min(window_h - view_y, view_h);
+	xi_touch.axis[1].scale = scale_y;
 }
 
-void X11_ScaleInput(SDL_VideoDevice *this, Sint16 *x, Sint16 *y);
+/* Device units to surface pixels, or -1 outside of the surface */
+static inline Sint16 X11_XInput2_MapTouch(_THIS, int axis, int v, int min,
+					  Uint32 scale)
+{
+	int u = ((((v - min) * (int)scale) + 0x8000) >> 16) -
+		xi_touch.axis[axis].origin;
+
+	if (u < xi_touch.axis[axis].lo || u >= xi_touch.axis[axis].hi) {
+		return -1;
+	}
+	return (Sint16)((u * xi_touch.axis[axis].scale) >> 16);
+}
 
 static int X11_XInput2_DispatchTouchDeviceEvent(_THIS, XIDeviceEvent *e)
 {
-	double v;
+	const unsigned char *mask = e->valuators.mask;
+	const int mask_bits = e->valuators.mask_len * 8;
+	const double *values = e->valuators.values;
+	SDL_TouchContact contacts[SDL_MAXTOUCH];
+	int num_contacts;
 	Sint16 x, y;
-	Uint16 active;
 	int i;
 
-	/* Sadly, we need to scale and clip the coordinates on our own. Prepare for this. */
-	const int screen_w = DisplayWidth(SDL_Display, SDL_Screen);
-	const int screen_h = DisplayHeight(SDL_Display, SDL_Screen);
-
-	active = 0;
-	for (i = 0; i < xi_master->num_classes; i++) {
-		XIAnyClassInfo* any = xi_master->classes[i];
-		if (xi_master->classes[i]->type == XIValuatorClass) {
-			XIValuatorClassInfo *valuator = (XIValuatorClassInfo*)(xi_master->classes[i]);
-			int n = valuator->number;
+	if (!xi_touch.valid) {
+		X11_XInput2_UpdateTouchMap(this);
+	}
 
-			if (!XIMaskIsSet(e->valuators.mask, n)) {
-				/* This event does not contain this evaluator's value. */
-				continue;
-			}
+	/* Every event is a frame with all the fingers down */
+	num_contacts = 0;
+	for (i = 0; i < xi_touch.count && num_contacts < SDL_MAXTOUCH; i++) {
+		const int nx = xi_touch.contact[i].x;
+		const int ny = xi_touch.contact[i].y;
+		const int np = xi_touch.contact[i].pressure;
+		const int nid = xi_touch.contact[i].id;
+		SDL_TouchContact *contact;
+		int id;
+
+		if (nid >= mask_bits || !XIMaskIsSet(mask, nid)) {
+			/* This event does not mention this contact point. */
+			continue;
+		}
+		/* Tracking ID indicates which finger we have been talking about previously. */
+		id = values[nid];
+		if (id < 0 || id > 255) {
+			continue;
+		}
 
-			if (valuator->label == atom(AbsMTPositionX)) {
-				v = e->valuators.values[n];
-				v = (v - valuator->min) / (valuator->max - valuator->min);
-				x = round(screen_w * v);
-				X11_XInput2_ClipTouch(&x, window_x, window_w);
-			} else if (valuator->label == atom(AbsMTPositionY)) {
-				v = e->valuators.values[n];
-				v = (v - valuator->min) / (valuator->max - valuator->min);
-				y = round(screen_h * v);
-				X11_XInput2_ClipTouch(&y, window_y, window_h);
-			} else if (valuator->label == atom(AbsMTTrackingID)) {
-				/* Tracking ID is always the last valuator for a contact point,
-				 * and indicates which finger we have been talking about previously. */
-				int id = e->valuators.values[n];
-				if (id >= SDL_MAXMOUSE) {
-					/* Too many contact points! Discard! */
-					continue;
-				}
-				if (x == -1 || y == -1) {
-					/* Outside of the window, discard. */
-					continue;
-				}
-				active |= 1 << id;
-				X11_ScaleInput(this, &x, &y);
-				if (SDL_GetMultiMouseState(id, NULL, NULL)) {
-					/* We already knew about this finger; therefore, this is motion. */
-					SDL_PrivateMultiMouseMotion(id, SDL_BUTTON_LMASK, 0, x, y);
-				} else {
-					/* We did not know about this finger; therefore, this is a button press. */
-					SDL_PrivateMultiMouseMotion(id, 0, 0, x, y);
-					SDL_PrivateMultiMouseButton(id, SDL_PRESSED, SDL_BUTTON_LEFT, 0, 0);
-				}
-			}
+		x = y = -1;
+		if (nx >= 0 && nx < mask_bits && XIMaskIsSet(mask, nx)) {
+			x = X11_XInput2_MapTouch(this, 0, values[nx],
+				xi_touch.contact[i].min_x, xi_touch.contact[i].scale_x);
+		}
+		if (ny >= 0 && ny < mask_bits && XIMaskIsSet(mask, ny)) {
+			y = X11_XInput2_MapTouch(this, 1, values[ny],
+				xi_touch.contact[i].min_y, xi_touch.contact[i].scale_y);
+		}
+		if (x == -1 || y == -1) {
+			/* Outside of the window, discard. */
+			continue;
 		}
-	}
 
-	/* Now enumerate all mouses and kill those that are not active. */
-	for (i = 0; i < SDL_MAXMOUSE; i++) {
-		if (!(active & (1 << i))) {
-			SDL_ResetMultiMouse(i); /* Will send released events for pressed buttons. */
+		contact = &contacts[num_contacts++];
+		contact->id = id;
+		contact->x = x;
+		contact->y = y;
+		contact->pressure = 0;
+		if (np >= 0 && np < mask_bits && XIMaskIsSet(mask, np) &&
+		    xi_touch.contact[i].range_pressure > 0) {
+			int p = values[np] - xi_touch.contact[i].min_pressure;
+			p = (int)(((Sint64)p * 0xFFFF) / xi_touch.contact[i].range_pressure);
+			contact->pressure = SDL_max(0, SDL_min(p, 0xFFFF));
 		}
 	}
 
-	return 1;
+	return SDL_PrivateTouch(num_contacts, contacts);
 }
 
 static int X11_XInput2_DispatchPointerDeviceEvent(_THIS, XIDeviceEvent *e)
@@ -561,19 +621,92 @@ static int X11_XInput2_DispatchEvent(_THIS, XIEvent *xevent)
 }
 #endif /* SDL_VIDEO_DRIVER_X11_XINPUT2 */
 
-static int X11_DispatchEvent(_THIS)
+/* Stamp the events queued for an X event with its server time, which
+   on Linux is CLOCK_MONOTONIC in milliseconds */
+static void X11_SetEventTime(Time time)
 {
-	int posted;
-	XEvent xevent;
+	Uint64 now = SDL_EventTimestampNow();
+#if HAVE_CLOCK_GETTIME
+	Sint32 age = (Sint32)((Uint32)(now / 1000) - (Uint32)time);
 
-	SDL_memset(&xevent, '\0', sizeof (XEvent));  /* valgrind fix. --ryan. */
-	XNextEvent(SDL_Display, &xevent);
+	if ( time != CurrentTime && age > 0 && age < 10000 ) {
+		now -= (Uint64)age * 1000;
+	}
+#endif
+	SDL_SetEventSourceTime(now);
+}
+
+static Time X11_EventTime(XEvent *xevent)
+{
+	switch (xevent->type) {
+	    case KeyPress:
+	    case KeyRelease:
+		return xevent->xkey.time;
+	    case ButtonPress:
+	    case ButtonRelease:
+		return xevent->xbutton.time;
+	    case MotionNotify:
+		return xevent->xmotion.time;
+	    case EnterNotify:
+	    case LeaveNotify:
+		return xevent->xcrossing.time;
+	}
+	return CurrentTime;
+}
+
+/* Take the next queued event, along with its XInput2 data */
+static void X11_NextEvent(_THIS, XEvent *xevent)
+{
+	SDL_memset(xevent, '\0', sizeof (XEvent));  /* valgrind fix. --ryan. */
+	XNextEvent(SDL_Display, xevent);
+#if SDL_VIDEO_DRIVER_X11_XINPUT2
+	if ( xevent->type == GenericEvent && use_xinput2 &&
+	     xevent->xcookie.extension == xi_opcode ) {
+		XGetEventData(SDL_Display, &xevent->xcookie);
+	}
+#endif
+}
+
+static void X11_FreeEvent(_THIS, XEvent *xevent)
+{
+#if SDL_VIDEO_DRIVER_X11_XINPUT2
+	if ( xevent->type == GenericEvent && xevent->xcookie.data ) {
+		XFreeEventData(SDL_Display, &xevent->xcookie);
+	}
+#endif
+}
+
+/* Whether 'next' is motion that makes 'xevent' obsolete */
+static int X11_SameMotion(_THIS, XEvent *xevent, XEvent *next)
+{
+	if ( xevent->type == MotionNotify ) {
+		return ( next->type == MotionNotify &&
+		         next->xmotion.window == xevent->xmotion.window &&
+		         next->xmotion.state == xevent->xmotion.state );
+	}
+#if SDL_VIDEO_DRIVER_X11_XINPUT2
+	if ( xevent->type == GenericEvent && xevent->xcookie.data &&
+	     xevent->xcookie.evtype == XI_Motion ) {
+		return ( next->type == GenericEvent && next->xcookie.data &&
+		         next->xcookie.extension == xevent->xcookie.extension &&
+		         next->xcookie.evtype == XI_Motion &&
+		         ((XIDeviceEvent*)next->xcookie.data)->deviceid ==
+		         ((XIDeviceEvent*)xevent->xcookie.data)->deviceid );
+	}
+#endif
+	return 0;
+}
+
+/* Dispatch an event taken with X11_NextEvent() */
+static int X11_DispatchEvent(_THIS, XEvent *xevent)
+{
+	int posted;
 
 	/* Discard KeyRelease and KeyPress events generated by auto-repeat.
 	   We need to do it before passing event to XFilterEvent.  Otherwise,
 	   KeyRelease aware IMs are confused...  */
-	if ( xevent.type == KeyRelease
-	     && X11_KeyRepeat(SDL_Display, &xevent) ) {
+	if ( xevent->type == KeyRelease
+	     && X11_KeyRepeat(SDL_Display, xevent) ) {
 		return 0;
 	}
 
@@ -582,54 +715,55 @@ static int X11_DispatchEvent(_THIS)
 	   to XFilterEvent, and discard those filtered events immediately.  */
 	if ( SDL_TranslateUNICODE
 	     && SDL_IM != NULL
-	     && XFilterEvent(&xevent, None) ) {
+	     && XFilterEvent(xevent, None) ) {
 		return 0;
 	}
 #endif
 
 	/* If there's an installed X11 event filter and it says "skip it", well,
 	   skip it. */
-	if ( event_filter != NULL && event_filter(&xevent) == 0 ) {
+	if ( event_filter != NULL && event_filter(xevent) == 0 ) {
 		return 0;
 	}
 
 	posted = 0;
-	switch (xevent.type) {
+	X11_SetEventTime(X11_EventTime(xevent));
+	switch (xevent->type) {
 
 	    /* Gaining mouse coverage? */
 	    case EnterNotify: {
 #ifdef DEBUG_XEVENTS
-printf("EnterNotify! (%d,%d)\n", xevent.xcrossing.x, xevent.xcrossing.y);
-if ( xevent.xcrossing.mode == NotifyGrab )
+printf("EnterNotify! (%d,%d)\n", xevent->xcrossing.x, xevent->xcrossing.y);
+if ( xevent->xcrossing.mode == NotifyGrab )
 printf("Mode: NotifyGrab\n");
-if ( xevent.xcrossing.mode == NotifyUngrab )
+if ( xevent->xcrossing.mode == NotifyUngrab )
 printf("Mode: NotifyUngrab\n");
 #endif
 		if ( this->input_grab == SDL_GRAB_OFF ) {
 			posted = SDL_PrivateAppActive(1, SDL_APPMOUSEFOCUS);
 		}
 		posted = SDL_PrivateMouseMotion(0, 0,
-				xevent.xcrossing.x,
-				xevent.xcrossing.y);
+				xevent->xcrossing.x,
+				xevent->xcrossing.y);
 	    }
 	    break;
 
 	    /* Losing mouse coverage? */
 	    case LeaveNotify: {
 #ifdef DEBUG_XEVENTS
-printf("LeaveNotify! (%d,%d)\n", xevent.xcrossing.x, xevent.xcrossing.y);
-if ( xevent.xcrossing.mode == NotifyGrab )
+printf("LeaveNotify! (%d,%d)\n", xevent->xcrossing.x, xevent->xcrossing.y);
+if ( xevent->xcrossing.mode == NotifyGrab )
 printf("Mode: NotifyGrab\n");
-if ( xevent.xcrossing.mode == NotifyUngrab )
+if ( xevent->xcrossing.mode == NotifyUngrab )
 printf("Mode: NotifyUngrab\n");
 #endif
-		if ( xevent.xcrossing.detail != NotifyInferior ) {
+		if ( xevent->xcrossing.detail != NotifyInferior ) {
 			if ( this->input_grab == SDL_GRAB_OFF ) {
 				posted = SDL_PrivateAppActive(0, SDL_APPMOUSEFOCUS);
 			} else {
 				posted = SDL_PrivateMouseMotion(0, 0,
-						xevent.xcrossing.x,
-						xevent.xcrossing.y);
+						xevent->xcrossing.x,
+						xevent->xcrossing.y);
 			}
 		}
 	    }
@@ -669,7 +803,7 @@ printf("FocusOut!\n");
 	    /* Some IM requires MappingNotify to be passed to
 	       XRefreshKeyboardMapping by the app.  */
 	    case MappingNotify: {
-		XRefreshKeyboardMapping(&xevent.xmapping);
+		XRefreshKeyboardMapping(&xevent->xmapping);
 	    }
 	    break;
 #endif /* X_HAVE_UTF8_STRING */
@@ -679,7 +813,7 @@ printf("FocusOut!\n");
 #ifdef DEBUG_XEVENTS
 printf("KeymapNotify!\n");
 #endif
-		X11_SetKeyboardState(SDL_Display,  xevent.xkeymap.key_vector);
+		X11_SetKeyboardState(SDL_Display,  xevent->xkeymap.key_vector);
 	    }
 	    break;
 
@@ -689,21 +823,21 @@ printf("KeymapNotify!\n");
 			if ( mouse_relative ) {
 				if ( using_dga & DGA_MOUSE ) {
 #ifdef DEBUG_MOTION
-  printf("DGA motion: %d,%d\n", xevent.xmotion.x_root, xevent.xmotion.y_root);
+  printf("DGA motion: %d,%d\n", xevent->xmotion.x_root, xevent->xmotion.y_root);
 #endif
 					posted = SDL_PrivateMouseMotion(0, 1,
-							xevent.xmotion.x_root,
-							xevent.xmotion.y_root);
+							xevent->xmotion.x_root,
+							xevent->xmotion.y_root);
 				} else {
-					posted = X11_WarpedMotion(this,&xevent);
+					posted = X11_WarpedMotion(this,xevent);
 				}
 			} else {
 #ifdef DEBUG_MOTION
-  printf("X11 motion: %d,%d\n", xevent.xmotion.x, xevent.xmotion.y);
+  printf("X11 motion: %d,%d\n", xevent->xmotion.x, xevent->xmotion.y);
 #endif
 				posted = SDL_PrivateMouseMotion(0, 0,
-						xevent.xmotion.x,
-						xevent.xmotion.y);
+						xevent->xmotion.x,
+						xevent->xmotion.y);
 			}
 		}
 	    }
@@ -712,24 +846,24 @@ printf("KeymapNotify!\n");
 	    /* Mouse button press? */
 	    case ButtonPress: {
 		posted = SDL_PrivateMouseButton(SDL_PRESSED, 
-					xevent.xbutton.button, 0, 0);
+					xevent->xbutton.button, 0, 0);
 	    }
 	    break;
 
 	    /* Mouse button release? */
 	    case ButtonRelease: {
 		posted = SDL_PrivateMouseButton(SDL_RELEASED, 
-					xevent.xbutton.button, 0, 0);
+					xevent->xbutton.button, 0, 0);
 	    }
 	    break;
 
 	    /* Key press? */
 	    case KeyPress: {
 		SDL_keysym keysym;
-		KeyCode keycode = xevent.xkey.keycode;
+		KeyCode keycode = xevent->xkey.keycode;
 
 #ifdef DEBUG_XEVENTS
-printf("KeyPress (X11 keycode = 0x%X)\n", xevent.xkey.keycode);
+printf("KeyPress (X11 keycode = 0x%X)\n", xevent->xkey.keycode);
 #endif
 		/* If we're not doing translation, we're done! */
 		if ( !SDL_TranslateUNICODE ) {
@@ -761,7 +895,7 @@ printf("KeyPress (X11 keycode = 0x%X)\n", xevent.xkey.keycode);
 			int utf16size;
 			int utf16length;
 
-			count = Xutf8LookupString(SDL_IC, &xevent.xkey, keydata, sizeof(keybuf), &xkeysym, &status);
+			count = Xutf8LookupString(SDL_IC, &xevent->xkey, keydata, sizeof(keybuf), &xkeysym, &status);
 			if (XBufferOverflow == status) {
 			  /* The IM has just generated somewhat long
 			     string.  We need a longer buffer in this
@@ -771,7 +905,7 @@ printf("KeyPress (X11 keycode = 0x%X)\n", xevent.xkey.keycode);
 			    SDL_OutOfMemory();
 			    break;
 			  }
-			  count = Xutf8LookupString(SDL_IC, &xevent.xkey, keydata, count, &xkeysym, &status);
+			  count = Xutf8LookupString(SDL_IC, &xevent->xkey, keydata, count, &xkeysym, &status);
 			}
 
 			switch (status) {
@@ -899,7 +1033,7 @@ printf("KeyPress (X11 keycode = 0x%X)\n", xevent.xkey.keycode);
 			keysym.sym = X11_TranslateKeycode(SDL_Display, keycode);
 			keysym.mod = KMOD_NONE;
 			keysym.unicode = 0;
-			if ( XLookupString(&xevent.xkey,
+			if ( XLookupString(&xevent->xkey,
 			                    keybuf, sizeof(keybuf),
 			                    NULL, &state) ) {
 				/*
@@ -919,7 +1053,7 @@ printf("KeyPress (X11 keycode = 0x%X)\n", xevent.xkey.keycode);
 	    /* Key release? */
 	    case KeyRelease: {
 		SDL_keysym keysym;
-		KeyCode keycode = xevent.xkey.keycode;
+		KeyCode keycode = xevent->xkey.keycode;
 
 		if (keycode == 0) {
 		  /* There should be no KeyRelease for keycode == 0,
@@ -930,7 +1064,7 @@ printf("KeyPress (X11 keycode = 0x%X)\n", xevent.xkey.keycode);
 		}
 
 #ifdef DEBUG_XEVENTS
-printf("KeyRelease (X11 keycode = 0x%X)\n", xevent.xkey.keycode);
+printf("KeyRelease (X11 keycode = 0x%X)\n", xevent->xkey.keycode);
 #endif
 
 		/* Get the translated SDL virtual keysym */
@@ -991,18 +1125,21 @@ printf("MapNotify!\n");
 	    /* Have we been resized or moved? */
 	    case ConfigureNotify: {
 #ifdef DEBUG_XEVENTS
-printf("ConfigureNotify! (resize: %dx%d)\n", xevent.xconfigure.width, xevent.xconfigure.height);
+printf("ConfigureNotify! (resize: %dx%d)\n", xevent->xconfigure.width, xevent->xconfigure.height);
+#endif
+		window_x = xevent->xconfigure.x;
+		window_y = xevent->xconfigure.y;
+#if SDL_VIDEO_DRIVER_X11_XINPUT2
+		xi_touch.valid = 0;
 #endif
-		window_x = xevent.xconfigure.x;
-		window_y = xevent.xconfigure.y;
 		if ( SDL_VideoSurface ) {
-		    if ((xevent.xconfigure.width != SDL_VideoSurface->w) ||
-		        (xevent.xconfigure.height != SDL_VideoSurface->h)) {
+		    if ((xevent->xconfigure.width != SDL_VideoSurface->w) ||
+		        (xevent->xconfigure.height != SDL_VideoSurface->h)) {
 			/* FIXME: Find a better fix for the bug with KDE 1.2 */
-			if ( ! ((xevent.xconfigure.width == 32) &&
-			        (xevent.xconfigure.height == 32)) ) {
-				SDL_PrivateResize(xevent.xconfigure.width,
-				                  xevent.xconfigure.height);
+			if ( ! ((xevent->xconfigure.width == 32) &&
+			        (xevent->xconfigure.height == 32)) ) {
+				SDL_PrivateResize(xevent->xconfigure.width,
+				                  xevent->xconfigure.height);
 			}
 		    } else {
 			/* OpenGL windows need to know about the change */
@@ -1015,19 +1152,22 @@ printf("ConfigureNotify! (resize: %dx%d)\n", xevent.xconfigure.width, xevent.xco
 	    break;
 
 		case ReparentNotify: {
-		window_x = xevent.xreparent.x;
-		window_y = xevent.xreparent.y;
+		window_x = xevent->xreparent.x;
+		window_y = xevent->xreparent.y;
+#if SDL_VIDEO_DRIVER_X11_XINPUT2
+		xi_touch.valid = 0;
+#endif
 		}
 		break;
 
 	    /* Has one of our window properties being changed? */
 	    case PropertyNotify:
 #ifdef DEBUG_XEVENTS
-printf("PropertyNotify atom = %d)\n", xevent.xproperty.atom);
+printf("PropertyNotify atom = %d)\n", xevent->xproperty.atom);
 #endif
-		if ( xevent.xproperty.window == WMwindow &&
-			 xevent.xproperty.state == PropertyNewValue &&
-			 xevent.xproperty.atom == atom(WM_STATE)) {
+		if ( xevent->xproperty.window == WMwindow &&
+			 xevent->xproperty.state == PropertyNewValue &&
+			 xevent->xproperty.atom == atom(WM_STATE)) {
 			Atom type;
 			int format;
 			unsigned long nitems, after;
@@ -1068,25 +1208,25 @@ printf("PropertyNotify atom = %d)\n", xevent.xproperty.atom);
 
 			SDL_VERSION(&wmmsg.version);
 			wmmsg.subsystem = SDL_SYSWM_X11;
-			wmmsg.event.xevent = xevent;
+			wmmsg.event.xevent = *xevent;
 			posted = SDL_PrivateSysWMEvent(&wmmsg);
 		}
 	    break;
 
 	    /* Have we been requested to quit (or another client message?) */
 	    case ClientMessage: {
-		if ( (xevent.xclient.format == 32) &&
-		     (xevent.xclient.data.l[0] == atom(WM_DELETE_WINDOW)) )
+		if ( (xevent->xclient.format == 32) &&
+		     (xevent->xclient.data.l[0] == atom(WM_DELETE_WINDOW)) )
 		{
 			posted = SDL_PrivateQuit();
 		} else
-		if ( (xevent.xclient.format == 32) &&
-		     (xevent.xclient.data.l[0] == atom(_NET_WM_PING)) )
+		if ( (xevent->xclient.format == 32) &&
+		     (xevent->xclient.data.l[0] == atom(_NET_WM_PING)) )
 		{
 			/* Window manager wants to know if we are still alive. */
-			xevent.xclient.window = DefaultRootWindow(SDL_Display);
-			XSendEvent(SDL_Display, xevent.xclient.window, False,
-				SubstructureRedirectMask | SubstructureNotifyMask, &xevent);
+			xevent->xclient.window = DefaultRootWindow(SDL_Display);
+			XSendEvent(SDL_Display, xevent->xclient.window, False,
+				SubstructureRedirectMask | SubstructureNotifyMask, xevent);
 			posted = 1;
 		} else
 		if ( SDL_ProcessEvents[SDL_SYSWMEVENT] == SDL_ENABLE ) {
@@ -1094,7 +1234,7 @@ printf("PropertyNotify atom = %d)\n", xevent.xproperty.atom);
 
 			SDL_VERSION(&wmmsg.version);
 			wmmsg.subsystem = SDL_SYSWM_X11;
-			wmmsg.event.xevent = xevent;
+			wmmsg.event.xevent = *xevent;
 			posted = SDL_PrivateSysWMEvent(&wmmsg);
 		}
 	    }
@@ -1103,9 +1243,9 @@ printf("PropertyNotify atom = %d)\n", xevent.xproperty.atom);
 	    /* Do we need to refresh ourselves? */
 	    case Expose: {
 #ifdef DEBUG_XEVENTS
-printf("Expose (count = %d)\n", xevent.xexpose.count);
+printf("Expose (count = %d)\n", xevent->xexpose.count);
 #endif
-		if ( SDL_VideoSurface && (xevent.xexpose.count == 0) ) {
+		if ( SDL_VideoSurface && (xevent->xexpose.count == 0) ) {
 			X11_RefreshDisplay(this);
 		}
 	    }
@@ -1113,10 +1253,10 @@ printf("Expose (count = %d)\n", xevent.xexpose.count);
 
 		case GenericEvent:
 #if SDL_VIDEO_DRIVER_X11_XINPUT2
-			if (use_xinput2 && xevent.xcookie.extension == xi_opcode) {
-				if (XGetEventData(SDL_Display, &xevent.xcookie)) {
-					posted = X11_XInput2_DispatchEvent(this, (XIEvent*) xevent.xcookie.data);
-					XFreeEventData(SDL_Display, &xevent.xcookie);
+			if (use_xinput2 && xevent->xcookie.extension == xi_opcode) {
+				if (xevent->xcookie.data) {
+					X11_SetEventTime(((XIEvent*) xevent->xcookie.data)->time);
+					posted = X11_XInput2_DispatchEvent(this, (XIEvent*) xevent->xcookie.data);
 				}
 			}
 #endif /* SDL_VIDEO_DRIVER_X11_XINPUT2 */
@@ -1124,7 +1264,7 @@ printf("Expose (count = %d)\n", xevent.xexpose.count);
 
 	    default: {
 #ifdef DEBUG_XEVENTS
-printf("Unhandled event %d\n", xevent.type);
+printf("Unhandled event %d\n", xevent->type);
 #endif
 		/* Only post the event if we're watching for it */
 		if ( SDL_ProcessEvents[SDL_SYSWMEVENT] == SDL_ENABLE ) {
@@ -1132,16 +1272,30 @@ printf("Unhandled event %d\n", xevent.type);
 
 			SDL_VERSION(&wmmsg.version);
 			wmmsg.subsystem = SDL_SYSWM_X11;
-			wmmsg.event.xevent = xevent;
+			wmmsg.event.xevent = *xevent;
 			posted = SDL_PrivateSysWMEvent(&wmmsg);
 		}
 	    }
 	    break;
 	}
+	SDL_SetEventSourceTime(0);
 	return(posted);
 }
 
-/* Ack!  XPending() actually performs a blocking read if no events available */
+/* See if X is ready to talk -- XPending() may block when nothing is */
+static int X11_Readable(Display *display)
+{
+	static struct timeval zero_time;	/* static == 0 */
+	int x11_fd;
+	fd_set fdset;
+
+	x11_fd = ConnectionNumber(display);
+	FD_ZERO(&fdset);
+	FD_SET(x11_fd, &fdset);
+	return ( select(x11_fd+1, &fdset, NULL, NULL, &zero_time) == 1 );
+}
+
+/* Used by the DGA driver, which still dispatches one event at a time */
 int X11_Pending(Display *display)
 {
 	/* Flush the display connection and look to see if events are queued */
@@ -1149,28 +1303,15 @@ int X11_Pending(Display *display)
 	if ( XEventsQueued(display, QueuedAlready) ) {
 		return(1);
 	}
-
-	/* More drastic measures are required -- see if X is ready to talk */
-	{
-		static struct timeval zero_time;	/* static == 0 */
-		int x11_fd;
-		fd_set fdset;
-
-		x11_fd = ConnectionNumber(display);
-		FD_ZERO(&fdset);
-		FD_SET(x11_fd, &fdset);
-		if ( select(x11_fd+1, &fdset, NULL, NULL, &zero_time) == 1 ) {
-			return(XPending(display));
-		}
+	if ( X11_Readable(display) ) {
+		return(XPending(display));
 	}
-
-	/* Oh well, nothing is ready .. */
 	return(0);
 }
 
 void X11_PumpEvents(_THIS)
 {
-	int pending;
+	XEvent xevent, next;
 
 	/* Update activity every five seconds to prevent screensaver. --ryan. */
 	if (!allow_screensaver) {
@@ -1182,12 +1323,32 @@ void X11_PumpEvents(_THIS)
 		}
 	}
 
-	/* Keep processing pending events */
-	pending = 0;
-	while ( X11_Pending(SDL_Display) ) {
-		X11_DispatchEvent(this);
-		++pending;
-	}
+	/* Flush once, then dispatch everything Xlib has queued before
+	   looking at the connection again */
+	XFlush(SDL_Display);
+	do {
+		while ( XEventsQueued(SDL_Display, QueuedAlready) ) {
+			X11_NextEvent(this, &xevent);
+			while ( compress_motion &&
+			        XEventsQueued(SDL_Display, QueuedAlready) ) {
+				XPeekEvent(SDL_Display, &next);
+				if ( next.type != xevent.type ||
+				     (next.type != MotionNotify &&
+				      next.type != GenericEvent) ) {
+					break;
+				}
+				X11_NextEvent(this, &next);
+				if ( ! X11_SameMotion(this, &xevent, &next) ) {
+					X11_DispatchEvent(this, &xevent);
+				}
+				X11_FreeEvent(this, &xevent);
+				xevent = next;
+			}
+			X11_DispatchEvent(this, &xevent);
+			X11_FreeEvent(this, &xevent);
+		}
+	} while ( X11_Readable(SDL_Display) &&
+	          XEventsQueued(SDL_Display, QueuedAfterReading) );
 }
 
 void X11_InitKeymap(void)
@@ -26,6 +26,12 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#if HAVE_CLOCK_GETTIME
+#include <time.h>
+#endif
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -33,15 +39,20 @@
 #include <GLES2/gl2ext.h>
 
 #include "SDL_endian.h"
+#include "SDL_thread.h"
 #include "../../events/SDL_events_c.h"
 #include "../SDL_pixels_c.h"
 #include "SDL_x11image_c.h"
+#include "SDL_x11yuv_c.h"
+#include "../SDL_yuvfuncs.h"
 
 static PFNEGLLOCKSURFACEKHRPROC eglLockSurfaceKHR;
 static PFNEGLUNLOCKSURFACEKHRPROC eglUnlockSurfaceKHR;
 static PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR;
 static PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR;
 static PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES;
+static PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOES;
+static PFNGLPROGRAMBINARYOESPROC glProgramBinaryOES;
 
 #if 0
 #define TRACE() printf("%s/%d\n", __func__, __LINE__)
@@ -62,13 +73,70 @@ struct private_hwdata {
 	SDL_VideoDevice *this;
 	int ref;
 	struct private_hwdata *finish_hwdata;
+	/* texture upload mode only */
+	Uint8 *pixels;
+	int pitch;
+	int dirty_y1, dirty_y2;
+	GLenum format, type;
+	/* placement in the backing texture, (0,0) unless in an atlas */
+	int x, y;
+	int tex_w, tex_h;
+	/* atlas sub-allocations only */
+	struct atlas_page *page;
+	int shelf;
+};
+
+/* How the screen is fitted to the display, see setup_view() */
+enum {
+	SCALE_ASPECT,	/* as large as fits, square pixels */
+	SCALE_INTEGER,	/* largest whole multiple that fits */
+	SCALE_STRETCH,	/* fill the display */
+	SCALE_SHARP,	/* aspect fit, bilinear only between source pixels */
+};
+
+/*
+ * Small HW surfaces share large pixmaps so blits from them don't need
+ * a texture bind each. Pages are split into horizontal shelves.
+ */
+#define ATLAS_SIZE 1024
+#define ATLAS_MAX_ITEM 128	/* larger surfaces get their own pixmap */
+#define ATLAS_ALIGN 8		/* shelf heights are multiples of this */
+#define ATLAS_MAX_SHELVES (ATLAS_SIZE / ATLAS_ALIGN)
+
+struct atlas_shelf {
+	int y, h;
+	int x;		/* first free column */
+	int items;	/* the shelf is reset once this drops to zero */
+};
+
+struct atlas_page {
+	struct private_hwdata *hwdata;	/* the shared pixmap and texture */
+	struct atlas_page *next;
+	int bpp;
+	int listed;	/* still accepting new surfaces */
+	struct atlas_shelf shelves[ATLAS_MAX_SHELVES];
+	int nshelves;
+	int top;	/* first row not given to a shelf */
+	int items;
+	/* EGL surfaces can't be locked twice, so locks nest here */
+	int locks;
+	Uint8 *pixels;
+	int pitch;
 };
 
 static struct private_hwdata screen_hwdata;
 
+static int has_extension(const char *extensions, const char *name);
 static void bind_framebuffer(struct SDL_PrivateVideoData *hidden, struct private_hwdata *hwdata);
 static void bind_texture(struct SDL_PrivateVideoData *hidden, struct private_hwdata *hwdata);
 static void set_finish_hwdata(struct private_hwdata *hwdata, struct private_hwdata *finish_hwdata);
+static void atlas_release(struct private_hwdata *hwdata);
+
+/* The hwdata owning the GL objects */
+static struct private_hwdata *backing(struct private_hwdata *hwdata)
+{
+	return hwdata && hwdata->page ? hwdata->page->hwdata : hwdata;
+}
 
 static void hwdata_free(struct private_hwdata *hwdata)
 {
@@ -77,6 +145,13 @@ static void hwdata_free(struct private_hwdata *hwdata)
 
 	TRACE();
 
+	/* Everything else belongs to the page */
+	if (hwdata->page) {
+		atlas_release(hwdata);
+		SDL_free(hwdata);
+		return;
+	}
+
 	if (glGetError())
 		ERROR();
 
@@ -108,6 +183,7 @@ static void hwdata_free(struct private_hwdata *hwdata)
 	if (hwdata->pixmap != None)
 		XFreePixmap(SDL_Display, hwdata->pixmap);
 
+	SDL_free(hwdata->pixels);
 	SDL_free(hwdata);
 
 	if (glGetError())
@@ -152,7 +228,12 @@ static void hwdata_unref(struct private_hwdata *hwdata)
 static void set_finish_hwdata(struct private_hwdata *hwdata,
 			      struct private_hwdata *finish_hwdata)
 {
-	struct private_hwdata *old_finish_hwdata = hwdata->finish_hwdata;
+	struct private_hwdata *old_finish_hwdata;
+
+	hwdata = backing(hwdata);
+	finish_hwdata = backing(finish_hwdata);
+
+	old_finish_hwdata = hwdata->finish_hwdata;
 	hwdata->finish_hwdata = hwdata_ref(finish_hwdata);
 	hwdata_unref(old_finish_hwdata);
 }
@@ -198,7 +279,238 @@ static void pixel_to_color(const SDL_PixelFormat *format,
 	}
 }
 
-static GLuint compile_shaders(const char *vs_source,
+/*
+ * Program binary cache (GL_OES_get_program_binary).
+ *
+ * Files are named after a hash of the GL vendor, renderer and version
+ * strings plus the shader sources, so a driver update or a shader
+ * change simply misses the cache.
+ */
+#define PROGRAM_CACHE_MAGIC 0x50474453 /* "SDGP" */
+
+struct program_cache_header {
+	Uint32 magic;
+	Uint32 format;
+	Uint32 length;
+	Uint32 reserved;
+	Uint64 key;
+};
+
+static Uint64 hash_string(Uint64 hash, const char *str)
+{
+	/* FNV-1a */
+	while (str && *str) {
+		hash ^= (Uint8) *str++;
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static int make_dir(const char *path)
+{
+	if (mkdir(path, 0700) < 0 && errno != EEXIST)
+		return -1;
+	return 0;
+}
+
+static void program_cache_init(struct SDL_PrivateVideoData *hidden)
+{
+	const char *env;
+	const char *base;
+	char path[1024];
+	GLint formats = 0;
+	Uint64 key;
+
+	TRACE();
+
+	env = SDL_getenv("SDL_VIDEO_X11_EGL_SHADER_CACHE");
+	if (env && !SDL_atoi(env))
+		return;
+
+	if (!glGetProgramBinaryOES || !glProgramBinaryOES ||
+	    !has_extension((const char *) glGetString(GL_EXTENSIONS), "GL_OES_get_program_binary"))
+		return;
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+	if (glGetError() || formats <= 0)
+		return;
+
+	base = SDL_getenv("XDG_CACHE_HOME");
+	if (base && *base) {
+		SDL_snprintf(path, sizeof path, "%s", base);
+	} else {
+		base = SDL_getenv("HOME");
+		if (!base || !*base)
+			return;
+		SDL_snprintf(path, sizeof path, "%s/.cache", base);
+	}
+	if (make_dir(path))
+		return;
+	SDL_strlcat(path, "/SDL", sizeof path);
+	if (make_dir(path))
+		return;
+
+	key = 0xcbf29ce484222325ULL;
+	key = hash_string(key, (const char *) glGetString(GL_VENDOR));
+	key = hash_string(key, (const char *) glGetString(GL_RENDERER));
+	key = hash_string(key, (const char *) glGetString(GL_VERSION));
+
+	hidden->gl.cache_dir = SDL_strdup(path);
+	hidden->gl.cache_key = key;
+	hidden->gl.cache_hits = 0;
+
+	DPRINTF("cache_dir = %s\n", hidden->gl.cache_dir);
+}
+
+static void program_cache_exit(struct SDL_PrivateVideoData *hidden)
+{
+	SDL_free(hidden->gl.cache_dir);
+	hidden->gl.cache_dir = NULL;
+}
+
+static Uint64 program_cache_path(struct SDL_PrivateVideoData *hidden,
+				 const char *vs_source, const char *fs_source,
+				 char *path, size_t len)
+{
+	Uint64 key;
+
+	key = hash_string(hidden->gl.cache_key, vs_source);
+	key = hash_string(key, fs_source);
+
+	SDL_snprintf(path, len, "%s/%08x%08x.prog", hidden->gl.cache_dir,
+		     (Uint32) (key >> 32), (Uint32) key);
+
+	return key;
+}
+
+static GLuint program_cache_load(struct SDL_PrivateVideoData *hidden,
+				 const char *vs_source, const char *fs_source)
+{
+	struct program_cache_header header;
+	char path[1024];
+	void *binary;
+	FILE *file;
+	GLuint prog;
+	GLint status = 0;
+	Uint64 key;
+
+	TRACE();
+
+	if (!hidden->gl.cache_dir)
+		return 0;
+
+	key = program_cache_path(hidden, vs_source, fs_source, path, sizeof path);
+
+	file = fopen(path, "rb");
+	if (!file)
+		return 0;
+
+	if (fread(&header, sizeof header, 1, file) != 1 ||
+	    header.magic != PROGRAM_CACHE_MAGIC || header.key != key ||
+	    header.length == 0 || header.length > 4 * 1024 * 1024)
+		goto close_file;
+
+	binary = SDL_malloc(header.length);
+	if (!binary)
+		goto close_file;
+
+	if (fread(binary, header.length, 1, file) != 1)
+		goto free_binary;
+
+	prog = glCreateProgram();
+	if (!prog)
+		goto free_binary;
+
+	glProgramBinaryOES(prog, header.format, binary, header.length);
+	glGetProgramiv(prog, GL_LINK_STATUS, &status);
+	if (glGetError() || !status)
+		goto delete_prog;
+
+	SDL_free(binary);
+	fclose(file);
+
+	hidden->gl.cache_hits++;
+
+	TRACE();
+
+	return prog;
+
+ delete_prog:
+	glDeleteProgram(prog);
+ free_binary:
+	SDL_free(binary);
+ close_file:
+	fclose(file);
+	/* stale or corrupt, recompile and replace it */
+	unlink(path);
+	return 0;
+}
+
+static void program_cache_save(struct SDL_PrivateVideoData *hidden, GLuint prog,
+			       const char *vs_source, const char *fs_source)
+{
+	struct program_cache_header header;
+	char path[1024];
+	char tmp[1040];
+	GLint length = 0;
+	GLenum format;
+	void *binary;
+	FILE *file;
+
+	TRACE();
+
+	if (!hidden->gl.cache_dir)
+		return;
+
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+	if (glGetError() || length <= 0)
+		return;
+
+	binary = SDL_malloc(length);
+	if (!binary)
+		return;
+
+	glGetProgramBinaryOES(prog, length, &length, &format, binary);
+	if (glGetError() || length <= 0)
+		goto free_binary;
+
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.format = format;
+	header.length = length;
+	header.reserved = 0;
+	header.key = program_cache_path(hidden, vs_source, fs_source, path, sizeof path);
+
+	/* Write and rename so concurrent readers never see a partial file */
+	SDL_snprintf(tmp, sizeof tmp, "%s.%d", path, (int) getpid());
+
+	file = fopen(tmp, "wb");
+	if (!file)
+		goto free_binary;
+
+	if (fwrite(&header, sizeof header, 1, file) != 1 ||
+	    fwrite(binary, length, 1, file) != 1) {
+		fclose(file);
+		goto remove_tmp;
+	}
+
+	if (fclose(file) || rename(tmp, path))
+		goto remove_tmp;
+
+	SDL_free(binary);
+
+	TRACE();
+
+	return;
+
+ remove_tmp:
+	unlink(tmp);
+ free_binary:
+	SDL_free(binary);
+	ERROR();
+}
+
+static GLuint compile_shaders(struct SDL_PrivateVideoData *hidden,
+			      const char *vs_source,
 			      const char *fs_source)
 {
 	GLuint vs, fs, prog;
@@ -206,6 +518,10 @@ static GLuint compile_shaders(const char *vs_source,
 
 	TRACE();
 
+	prog = program_cache_load(hidden, vs_source, fs_source);
+	if (prog)
+		return prog;
+
 	vs = glCreateShader(GL_VERTEX_SHADER);
 	if (!vs)
 		goto out;
@@ -247,6 +563,8 @@ static GLuint compile_shaders(const char *vs_source,
 	glDeleteShader(vs);
 	glDeleteShader(fs);
 
+	program_cache_save(hidden, prog, vs_source, fs_source);
+
 	TRACE();
 
 	return prog;
@@ -284,7 +602,7 @@ static int compile_fill_shaders(struct SDL_PrivateVideoData *hidden)
 	TRACE();
 
 	if (!hidden->gl.prog_fill)
-		hidden->gl.prog_fill = compile_shaders(vs, fs);
+		hidden->gl.prog_fill = compile_shaders(hidden, vs, fs);
 
 	return hidden->gl.prog_fill ? 0 : -1;
 }
@@ -317,7 +635,7 @@ static int compile_blit_shaders(struct SDL_PrivateVideoData *hidden)
 	TRACE();
 
 	if (!hidden->gl.prog_blit)
-		hidden->gl.prog_blit = compile_shaders(vs, fs);
+		hidden->gl.prog_blit = compile_shaders(hidden, vs, fs);
 
 	return hidden->gl.prog_blit ? 0 : -1;
 }
@@ -352,11 +670,173 @@ static int compile_ckey_shaders(struct SDL_PrivateVideoData *hidden)
 	TRACE();
 
 	if (!hidden->gl.prog_ckey)
-		hidden->gl.prog_ckey = compile_shaders(vs, fs);
+		hidden->gl.prog_ckey = compile_shaders(hidden, vs, fs);
 
 	return hidden->gl.prog_ckey ? 0 : -1;
 }
 
+/* BT.601 limited range to RGB, shared by the YUV overlay shaders */
+#define YUV_TO_RGB \
+	" y = 1.164 * (y - 0.0625);\n" \
+	" u = u - 0.5;\n" \
+	" v = v - 0.5;\n" \
+	" gl_FragColor = vec4(y + 1.596 * v,\n" \
+	"                     y - 0.391 * u - 0.813 * v,\n" \
+	"                     y + 2.018 * u,\n" \
+	"                     1.0);\n"
+
+static int compile_yuv_shaders(struct SDL_PrivateVideoData *hidden)
+{
+	static const char *vs =
+		"precision mediump float;\n"
+		"attribute vec2 in_position;\n"
+		"attribute vec2 in_texcoord;\n"
+		"varying vec2 texcoord;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		" gl_Position = vec4(in_position, 0.0, 1.0);\n"
+		" texcoord = in_texcoord;\n"
+		"}\n";
+	static const char *fs =
+		"precision mediump float;\n"
+		"uniform sampler2D tex_y;\n"
+		"uniform sampler2D tex_u;\n"
+		"uniform sampler2D tex_v;\n"
+		"varying vec2 texcoord;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		" float y = texture2D(tex_y, texcoord).r;\n"
+		" float u = texture2D(tex_u, texcoord).r;\n"
+		" float v = texture2D(tex_v, texcoord).r;\n"
+		YUV_TO_RGB
+		"}\n";
+
+	TRACE();
+
+	if (!hidden->gl.prog_yuv)
+		hidden->gl.prog_yuv = compile_shaders(hidden, vs, fs);
+
+	return hidden->gl.prog_yuv ? 0 : -1;
+}
+
+static int compile_nv12_shaders(struct SDL_PrivateVideoData *hidden)
+{
+	static const char *vs =
+		"precision mediump float;\n"
+		"attribute vec2 in_position;\n"
+		"attribute vec2 in_texcoord;\n"
+		"varying vec2 texcoord;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		" gl_Position = vec4(in_position, 0.0, 1.0);\n"
+		" texcoord = in_texcoord;\n"
+		"}\n";
+	static const char *fs =
+		"precision mediump float;\n"
+		"uniform sampler2D tex_y;\n"
+		"uniform sampler2D tex_u;\n"
+		"varying vec2 texcoord;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		" float y = texture2D(tex_y, texcoord).r;\n"
+		" vec4 uv = texture2D(tex_u, texcoord);\n"
+		" float u = uv.r;\n"
+		" float v = uv.a;\n"
+		YUV_TO_RGB
+		"}\n";
+
+	TRACE();
+
+	if (!hidden->gl.prog_nv12)
+		hidden->gl.prog_nv12 = compile_shaders(hidden, vs, fs);
+
+	return hidden->gl.prog_nv12 ? 0 : -1;
+}
+
+/* 8bpp screens: the index texture is resolved through a 256x1 palette */
+static int compile_pal_shaders(struct SDL_PrivateVideoData *hidden)
+{
+	static const char *vs =
+		"precision mediump float;\n"
+		"attribute vec2 in_position;\n"
+		"attribute vec2 in_texcoord;\n"
+		"varying vec2 texcoord;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		" gl_Position = vec4(in_position, 0.0, 1.0);\n"
+		" texcoord = in_texcoord;\n"
+		"}\n";
+	static const char *fs =
+		"precision mediump float;\n"
+		"uniform sampler2D tex;\n"
+		"uniform sampler2D palette;\n"
+		"uniform vec4 color;\n"
+		"varying vec2 texcoord;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		" float index = texture2D(tex, texcoord).r;\n"
+		" vec4 texel = texture2D(palette, vec2(index * (255.0 / 256.0) + (0.5 / 256.0), 0.5));\n"
+		" gl_FragColor = vec4(texel.rgb, color.a);\n"
+		"}\n";
+
+	TRACE();
+
+	if (!hidden->gl.prog_pal)
+		hidden->gl.prog_pal = compile_shaders(hidden, vs, fs);
+
+	return hidden->gl.prog_pal ? 0 : -1;
+}
+
+/*
+ * Sharp bilinear: nearest within each source pixel, linear only across
+ * the one output pixel straddling a boundary. prescale is the integer
+ * part of the scale factor.
+ */
+static int compile_sharp_shaders(struct SDL_PrivateVideoData *hidden)
+{
+	static const char *vs =
+		"precision mediump float;\n"
+		"attribute vec2 in_position;\n"
+		"attribute vec2 in_texcoord;\n"
+		"varying vec2 texcoord;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		" gl_Position = vec4(in_position, 0.0, 1.0);\n"
+		" texcoord = in_texcoord;\n"
+		"}\n";
+	static const char *fs =
+		"precision mediump float;\n"
+		"uniform sampler2D tex;\n"
+		"uniform vec4 color;\n"
+		"uniform vec2 tex_size;\n"
+		"uniform vec2 prescale;\n"
+		"varying vec2 texcoord;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		" vec2 texel = texcoord * tex_size;\n"
+		" vec2 region = 0.5 - 0.5 / prescale;\n"
+		" vec2 dist = fract(texel) - 0.5;\n"
+		" vec2 f = (dist - clamp(dist, -region, region)) * prescale + 0.5;\n"
+		" vec4 c = texture2D(tex, (floor(texel) + f) / tex_size);\n"
+		" gl_FragColor = vec4(c.rgb, c.a * color.a);\n"
+		"}\n";
+
+	TRACE();
+
+	if (!hidden->gl.prog_sharp)
+		hidden->gl.prog_sharp = compile_shaders(hidden, vs, fs);
+
+	return hidden->gl.prog_sharp ? 0 : -1;
+}
+
 static void draw_quad(const GLfloat *verts,
 		      const GLfloat *texcoords,
 		      const struct rgba_color *color,
@@ -386,6 +866,8 @@ static void draw_quad(const GLfloat *verts,
 
 static void bind_texture(struct SDL_PrivateVideoData *hidden, struct private_hwdata *hwdata)
 {
+	hwdata = backing(hwdata);
+
 	if (hidden->gl.tex_hwdata == hwdata)
 		return;
 
@@ -399,6 +881,8 @@ static void bind_texture(struct SDL_PrivateVideoData *hidden, struct private_hwd
 
 static void bind_framebuffer(struct SDL_PrivateVideoData *hidden, struct private_hwdata *hwdata)
 {
+	hwdata = backing(hwdata);
+
 	if (hwdata == &screen_hwdata)
 		hwdata = NULL;
 
@@ -413,48 +897,313 @@ static void bind_framebuffer(struct SDL_PrivateVideoData *hidden, struct private
 	TRACE();
 }
 
-#define ARRAY_SIZE(a) (int)(sizeof(a)/sizeof((a)[0]))
-#define DEF_ATTR(ATTR) { .name = #ATTR, .attr = ATTR, }
-
-static void print_configs(struct SDL_PrivateVideoData *hidden)
+static struct private_hwdata *alloc_pixmap_hwdata(SDL_VideoDevice *this,
+						  int w, int h, int bpp)
 {
-	XWindowAttributes attr;
-	EGLConfig config[64];
-	int num_config;
-	static struct {
-		const char *name;
-		EGLint attr;
-	} attrs[] = {
-		DEF_ATTR(EGL_BUFFER_SIZE),
-		DEF_ATTR(EGL_ALPHA_SIZE),
-		DEF_ATTR(EGL_BLUE_SIZE),
-		DEF_ATTR(EGL_GREEN_SIZE),
-		DEF_ATTR(EGL_RED_SIZE),
-		DEF_ATTR(EGL_DEPTH_SIZE),
-		DEF_ATTR(EGL_STENCIL_SIZE),
-		DEF_ATTR(EGL_CONFIG_CAVEAT),
-		DEF_ATTR(EGL_CONFIG_ID),
-		DEF_ATTR(EGL_LEVEL),
-		DEF_ATTR(EGL_MAX_PBUFFER_HEIGHT),
-		DEF_ATTR(EGL_MAX_PBUFFER_PIXELS),
-		DEF_ATTR(EGL_MAX_PBUFFER_WIDTH),
-		DEF_ATTR(EGL_NATIVE_RENDERABLE),
-		DEF_ATTR(EGL_NATIVE_VISUAL_ID),
-		DEF_ATTR(EGL_NATIVE_VISUAL_TYPE),
-		DEF_ATTR(EGL_SAMPLES),
-		DEF_ATTR(EGL_SAMPLE_BUFFERS),
-		DEF_ATTR(EGL_SURFACE_TYPE),
-		DEF_ATTR(EGL_TRANSPARENT_TYPE),
-		DEF_ATTR(EGL_TRANSPARENT_BLUE_VALUE),
-		DEF_ATTR(EGL_TRANSPARENT_GREEN_VALUE),
-		DEF_ATTR(EGL_TRANSPARENT_RED_VALUE),
-		DEF_ATTR(EGL_BIND_TO_TEXTURE_RGB),
-		DEF_ATTR(EGL_BIND_TO_TEXTURE_RGBA),
-		DEF_ATTR(EGL_MIN_SWAP_INTERVAL),
-		DEF_ATTR(EGL_MAX_SWAP_INTERVAL),
-		DEF_ATTR(EGL_LUMINANCE_SIZE),
-		DEF_ATTR(EGL_ALPHA_MASK_SIZE),
-		DEF_ATTR(EGL_COLOR_BUFFER_TYPE),
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *hwdata;
+	XVisualInfo vinfo;
+	EGLint attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PIXMAP_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_NATIVE_VISUAL_ID, 0,
+		EGL_NONE,
+	};
+	static const EGLint image_attribs[] = {
+		EGL_IMAGE_PRESERVED_KHR, EGL_TRUE,
+		EGL_NONE,
+	};
+
+	EGLint num_config;
+	EGLConfig config;
+
+	TRACE();
+
+	hwdata = hwdata_alloc(this);
+	if (!hwdata)
+		goto out;
+
+	if (!XMatchVisualInfo(SDL_Display, SDL_Screen, bpp, TrueColor, &vinfo))
+		goto free_hwdata;
+
+	attribs[5] = vinfo.visualid;
+
+	if (!eglChooseConfig(hidden->egl.dpy, attribs, &config, 1, &num_config))
+		goto free_hwdata;
+
+	DPRINTF("%p: w=%d h=%d bpp=%d\n", hwdata, w, h, bpp);
+
+	hwdata->pixmap = XCreatePixmap(SDL_Display, SDL_Root, w, h, bpp);
+	if (hwdata->pixmap == None)
+		goto free_hwdata;
+
+	hwdata->surface = eglCreatePixmapSurface(hidden->egl.dpy, config, (NativePixmapType) hwdata->pixmap, NULL);
+	if (hwdata->surface == EGL_NO_SURFACE)
+		goto free_hwdata;
+
+	hwdata->image = eglCreateImageKHR(hidden->egl.dpy, EGL_NO_CONTEXT,
+					  EGL_NATIVE_PIXMAP_KHR, (EGLClientBuffer) hwdata->pixmap, image_attribs);
+	if (hwdata->image == EGL_NO_IMAGE_KHR)
+		goto free_hwdata;
+
+	glGenFramebuffers(1, &hwdata->fbo);
+	glGenTextures(1, &hwdata->tex);
+
+	bind_texture(hidden, hwdata);
+	bind_framebuffer(hidden, hwdata);
+
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, hwdata->image);
+
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			       GL_TEXTURE_2D, hwdata->tex, 0);
+
+	glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	set_finish_hwdata(hwdata, hwdata);
+
+	hwdata->tex_w = w;
+	hwdata->tex_h = h;
+
+	TRACE();
+
+	return hwdata;
+
+ free_hwdata:
+	hwdata_unref(hwdata);
+ out:
+	ERROR();
+	return NULL;
+}
+
+static int alloc_pixmap_surface(SDL_VideoDevice *this, SDL_Surface *surface)
+{
+	struct private_hwdata *hwdata;
+
+	hwdata = alloc_pixmap_hwdata(this, surface->w, surface->h,
+				     surface->format->BitsPerPixel);
+	if (!hwdata) {
+		surface->flags &= ~SDL_HWSURFACE;
+		return -1;
+	}
+
+	surface->hwdata = hwdata;
+	surface->flags |= SDL_HWSURFACE | SDL_PREALLOC;
+
+	return 0;
+}
+
+/* Returns the shelf index, or -1 if the page is full */
+static int atlas_pack(struct atlas_page *page, int w, int h, int *x, int *y)
+{
+	struct atlas_shelf *best = NULL;
+	int i;
+
+	h = (h + ATLAS_ALIGN - 1) & ~(ATLAS_ALIGN - 1);
+
+	/* Best fit, but don't bury short surfaces in tall shelves */
+	for (i = 0; i < page->nshelves; i++) {
+		struct atlas_shelf *shelf = &page->shelves[i];
+
+		if (shelf->h < h || shelf->x + w > ATLAS_SIZE)
+			continue;
+		if (shelf->items && shelf->h > 2 * h)
+			continue;
+		if (!best || shelf->h < best->h)
+			best = shelf;
+	}
+
+	if (!best) {
+		if (page->nshelves == ATLAS_MAX_SHELVES ||
+		    page->top + h > ATLAS_SIZE)
+			return -1;
+		best = &page->shelves[page->nshelves++];
+		best->y = page->top;
+		best->h = h;
+		best->x = 0;
+		best->items = 0;
+		page->top += h;
+	}
+
+	*x = best->x;
+	*y = best->y;
+	best->x += w;
+	best->items++;
+	page->items++;
+
+	return best - page->shelves;
+}
+
+static void atlas_free_page(struct SDL_PrivateVideoData *hidden, struct atlas_page *page)
+{
+	struct atlas_page **prev;
+
+	DPRINTF("page %p\n", page);
+
+	if (page->listed) {
+		for (prev = (struct atlas_page **) &hidden->gl.atlas; *prev; prev = &(*prev)->next) {
+			if (*prev == page) {
+				*prev = page->next;
+				break;
+			}
+		}
+	}
+
+	/* Pending blits may still hold a reference to the pixmap */
+	hwdata_unref(page->hwdata);
+	SDL_free(page);
+}
+
+static int atlas_alloc(SDL_VideoDevice *this, SDL_Surface *surface)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *hwdata;
+	struct atlas_page *page;
+	int bpp = surface->format->BitsPerPixel;
+	/* One pixel gap, X11_HWBlit keeps linear filtering out of it */
+	int w = surface->w + 1;
+	int h = surface->h + 1;
+
+	TRACE();
+
+	hwdata = hwdata_alloc(this);
+	if (!hwdata)
+		goto out;
+
+	for (page = hidden->gl.atlas; page; page = page->next) {
+		if (page->bpp != bpp)
+			continue;
+		hwdata->shelf = atlas_pack(page, w, h, &hwdata->x, &hwdata->y);
+		if (hwdata->shelf >= 0)
+			break;
+	}
+
+	if (!page) {
+		page = SDL_calloc(1, sizeof *page);
+		if (!page)
+			goto free_hwdata;
+
+		page->hwdata = alloc_pixmap_hwdata(this, ATLAS_SIZE, ATLAS_SIZE, bpp);
+		if (!page->hwdata) {
+			SDL_free(page);
+			goto free_hwdata;
+		}
+		page->bpp = bpp;
+		page->listed = 1;
+		page->next = hidden->gl.atlas;
+		hidden->gl.atlas = page;
+
+		DPRINTF("page %p\n", page);
+
+		hwdata->shelf = atlas_pack(page, w, h, &hwdata->x, &hwdata->y);
+	}
+
+	hwdata->page = page;
+	hwdata->tex_w = ATLAS_SIZE;
+	hwdata->tex_h = ATLAS_SIZE;
+
+	DPRINTF("%p: %dx%d at %d,%d in page %p\n", surface, surface->w, surface->h,
+		hwdata->x, hwdata->y, page);
+
+	surface->hwdata = hwdata;
+	surface->flags |= SDL_HWSURFACE | SDL_PREALLOC;
+
+	TRACE();
+
+	return 0;
+
+ free_hwdata:
+	SDL_free(hwdata);
+ out:
+	ERROR();
+	return -1;
+}
+
+static void atlas_release(struct private_hwdata *hwdata)
+{
+	struct atlas_page *page = hwdata->page;
+	struct SDL_PrivateVideoData *hidden = page->hwdata->this->hidden;
+	struct atlas_shelf *shelf = &page->shelves[hwdata->shelf];
+
+	TRACE();
+
+	/* Space is reclaimed a whole shelf at a time */
+	if (--shelf->items == 0) {
+		shelf->x = 0;
+		while (page->nshelves && !page->shelves[page->nshelves - 1].items) {
+			page->nshelves--;
+			page->top = page->shelves[page->nshelves].y;
+		}
+	}
+
+	/* Keep the newest page around to avoid churn */
+	if (--page->items == 0 && (!page->listed || page != hidden->gl.atlas))
+		atlas_free_page(hidden, page);
+}
+
+static void atlas_exit(struct SDL_PrivateVideoData *hidden)
+{
+	struct atlas_page *page, *next;
+
+	for (page = hidden->gl.atlas; page; page = next) {
+		next = page->next;
+		page->listed = 0;
+		page->next = NULL;
+		/* Pages still in use go away with their last surface */
+		if (!page->items)
+			atlas_free_page(hidden, page);
+	}
+
+	hidden->gl.atlas = NULL;
+}
+
+#define ARRAY_SIZE(a) (int)(sizeof(a)/sizeof((a)[0]))
+#define DEF_ATTR(ATTR) { .name = #ATTR, .attr = ATTR, }
+
+static void print_configs(struct SDL_PrivateVideoData *hidden)
+{
+	XWindowAttributes attr;
+	EGLConfig config[64];
+	int num_config;
+	static struct {
+		const char *name;
+		EGLint attr;
+	} attrs[] = {
+		DEF_ATTR(EGL_BUFFER_SIZE),
+		DEF_ATTR(EGL_ALPHA_SIZE),
+		DEF_ATTR(EGL_BLUE_SIZE),
+		DEF_ATTR(EGL_GREEN_SIZE),
+		DEF_ATTR(EGL_RED_SIZE),
+		DEF_ATTR(EGL_DEPTH_SIZE),
+		DEF_ATTR(EGL_STENCIL_SIZE),
+		DEF_ATTR(EGL_CONFIG_CAVEAT),
+		DEF_ATTR(EGL_CONFIG_ID),
+		DEF_ATTR(EGL_LEVEL),
+		DEF_ATTR(EGL_MAX_PBUFFER_HEIGHT),
+		DEF_ATTR(EGL_MAX_PBUFFER_PIXELS),
+		DEF_ATTR(EGL_MAX_PBUFFER_WIDTH),
+		DEF_ATTR(EGL_NATIVE_RENDERABLE),
+		DEF_ATTR(EGL_NATIVE_VISUAL_ID),
+		DEF_ATTR(EGL_NATIVE_VISUAL_TYPE),
+		DEF_ATTR(EGL_SAMPLES),
+		DEF_ATTR(EGL_SAMPLE_BUFFERS),
+		DEF_ATTR(EGL_SURFACE_TYPE),
+		DEF_ATTR(EGL_TRANSPARENT_TYPE),
+		DEF_ATTR(EGL_TRANSPARENT_BLUE_VALUE),
+		DEF_ATTR(EGL_TRANSPARENT_GREEN_VALUE),
+		DEF_ATTR(EGL_TRANSPARENT_RED_VALUE),
+		DEF_ATTR(EGL_BIND_TO_TEXTURE_RGB),
+		DEF_ATTR(EGL_BIND_TO_TEXTURE_RGBA),
+		DEF_ATTR(EGL_MIN_SWAP_INTERVAL),
+		DEF_ATTR(EGL_MAX_SWAP_INTERVAL),
+		DEF_ATTR(EGL_LUMINANCE_SIZE),
+		DEF_ATTR(EGL_ALPHA_MASK_SIZE),
+		DEF_ATTR(EGL_COLOR_BUFFER_TYPE),
 		DEF_ATTR(EGL_RENDERABLE_TYPE),
 		DEF_ATTR(EGL_MATCH_NATIVE_PIXMAP),
 		DEF_ATTR(EGL_CONFORMANT),
@@ -481,6 +1230,21 @@ static void print_configs(struct SDL_PrivateVideoData *hidden)
 	fflush(stdout);
 }
 
+static int has_extension(const char *extensions, const char *name)
+{
+	size_t len = SDL_strlen(name);
+	const char *p = extensions;
+
+	while (p && (p = SDL_strstr(p, name)) != NULL) {
+		if ((p == extensions || p[-1] == ' ') &&
+		    (p[len] == ' ' || p[len] == '\0'))
+			return 1;
+		p += len;
+	}
+
+	return 0;
+}
+
 static EGLConfig pick_config(SDL_VideoDevice *this)
 {
 	XWindowAttributes attr;
@@ -505,9 +1269,20 @@ static EGLConfig pick_config(SDL_VideoDevice *this)
 
 	attribs[5] = attr.visual->visualid;
 
+	if (hidden->gl.upload)
+		attribs[1] = EGL_WINDOW_BIT;
+
 	if (!eglChooseConfig(hidden->egl.dpy, attribs, &config, 1, &num_config))
 		goto out;
 
+	/* Pixmap rendering not available, stream the pixels instead */
+	if (num_config == 0 && !hidden->gl.upload) {
+		hidden->gl.upload = 1;
+		attribs[1] = EGL_WINDOW_BIT;
+		if (!eglChooseConfig(hidden->egl.dpy, attribs, &config, 1, &num_config))
+			goto out;
+	}
+
 	DPRINTF("config = %p\n", num_config ? config : NULL);
 
 	if (num_config != 1)
@@ -530,6 +1305,8 @@ static int egl_init(SDL_VideoDevice *this)
 	};
 	EGLint major, minor;
 	EGLConfig config;
+	const char *extensions;
+	const char *env;
 	struct SDL_PrivateVideoData *hidden = this->hidden;
 
 	TRACE();
@@ -544,6 +1321,19 @@ static int egl_init(SDL_VideoDevice *this)
 	if (!eglInitialize(hidden->egl.dpy, &major, &minor))
 		goto terminate;
 
+	env = SDL_getenv("SDL_VIDEO_X11_EGL_UPLOAD");
+	hidden->gl.upload = env && SDL_atoi(env);
+
+	env = SDL_getenv("SDL_VIDEO_X11_EGL_ATLAS");
+	hidden->gl.use_atlas = !env || SDL_atoi(env);
+
+	extensions = eglQueryString(hidden->egl.dpy, EGL_EXTENSIONS);
+	if (!has_extension(extensions, "EGL_KHR_lock_surface") &&
+	    !has_extension(extensions, "EGL_KHR_lock_surface2"))
+		hidden->gl.upload = 1;
+	if (!has_extension(extensions, "EGL_KHR_image_pixmap"))
+		hidden->gl.upload = 1;
+
 	//print_configs(this);
 
 	config = pick_config(this);
@@ -553,6 +1343,7 @@ static int egl_init(SDL_VideoDevice *this)
 	hidden->egl.ctx = eglCreateContext(hidden->egl.dpy, config, EGL_NO_CONTEXT, attribs);
 	if (hidden->egl.ctx == EGL_NO_CONTEXT)
 		goto terminate;
+	hidden->egl.serial++;
 
 	eglLockSurfaceKHR = (PFNEGLLOCKSURFACEKHRPROC)
 		eglGetProcAddress("eglLockSurfaceKHR");
@@ -566,6 +1357,21 @@ static int egl_init(SDL_VideoDevice *this)
 	glEGLImageTargetTexture2DOES = (PFNGLEGLIMAGETARGETTEXTURE2DOESPROC)
 		eglGetProcAddress("glEGLImageTargetTexture2DOES");
 
+	glGetProgramBinaryOES = (PFNGLGETPROGRAMBINARYOESPROC)
+		eglGetProcAddress("glGetProgramBinaryOES");
+	glProgramBinaryOES = (PFNGLPROGRAMBINARYOESPROC)
+		eglGetProcAddress("glProgramBinaryOES");
+
+	if (!eglLockSurfaceKHR || !eglUnlockSurfaceKHR ||
+	    !eglCreateImageKHR || !eglDestroyImageKHR ||
+	    !glEGLImageTargetTexture2DOES)
+		hidden->gl.upload = 1;
+
+	DPRINTF("upload = %d\n", hidden->gl.upload);
+
+	/* The depth of each mode may still force it */
+	hidden->gl.upload_required = hidden->gl.upload;
+
 	TRACE();
 
 	return 0;
@@ -587,19 +1393,40 @@ static void egl_exit(SDL_VideoDevice *this)
 	if (hidden->egl.dpy == EGL_NO_DISPLAY)
 		return;
 
+	atlas_exit(hidden);
+
+	glDeleteTextures(1, &hidden->gl.cursor_tex);
+	glDeleteTextures(1, &hidden->gl.palette_tex);
+	glDeleteProgram(hidden->gl.prog_sharp);
+	glDeleteProgram(hidden->gl.prog_pal);
+	glDeleteProgram(hidden->gl.prog_nv12);
+	glDeleteProgram(hidden->gl.prog_yuv);
 	glDeleteProgram(hidden->gl.prog_ckey);
 	glDeleteProgram(hidden->gl.prog_blit);
 	glDeleteProgram(hidden->gl.prog_fill);
 
 	eglMakeCurrent(hidden->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
-	eglDestroyContext(hidden->egl.dpy, hidden->egl.dpy);
+	if (hidden->egl.surface != EGL_NO_SURFACE)
+		eglDestroySurface(hidden->egl.dpy, hidden->egl.surface);
+
+	eglDestroyContext(hidden->egl.dpy, hidden->egl.ctx);
 
 	eglTerminate(hidden->egl.dpy);
 
 	hidden->gl.prog_fill = 0;
 	hidden->gl.prog_blit = 0;
 	hidden->gl.prog_ckey = 0;
+	hidden->gl.prog_yuv = 0;
+	hidden->gl.prog_nv12 = 0;
+	hidden->gl.prog_pal = 0;
+	hidden->gl.prog_sharp = 0;
+	hidden->gl.palette_tex = 0;
+	hidden->gl.cursor_tex = 0;
+	hidden->gl.upload = 0;
+	hidden->gl.upload_required = 0;
+	program_cache_exit(hidden);
+	hidden->egl.surface = EGL_NO_SURFACE;
 	hidden->egl.ctx = EGL_NO_CONTEXT;
 	hidden->egl.dpy = EGL_NO_DISPLAY;
 
@@ -608,202 +1435,707 @@ static void egl_exit(SDL_VideoDevice *this)
 
 static void X11_UpdateRects(SDL_VideoDevice *this, int numrects, SDL_Rect *rects);
 
-static int setup_screen(SDL_VideoDevice *this, SDL_Surface *screen)
+/*
+ * Texture upload mode: the screen lives in system memory and
+ * the rows touched by UpdateRects are streamed into a texture.
+ */
+static int alloc_upload_hwdata(SDL_VideoDevice *this, SDL_Surface *surface)
 {
 	struct SDL_PrivateVideoData *hidden = this->hidden;
-	struct private_hwdata *hwdata = screen->hwdata;
-	EGLConfig config;
-	int r;
+	struct private_hwdata *hwdata;
 
 	TRACE();
 
-	if (hwdata)
-		return 0;
-
-	if (egl_init(this))
+	hwdata = hwdata_alloc(this);
+	if (!hwdata)
 		goto out;
 
-	config = pick_config(this);
-	if (!config)
-		goto free_hwsurface;
+	switch (surface->format->BitsPerPixel) {
+	case 8:
+		hwdata->format = GL_LUMINANCE;
+		hwdata->type = GL_UNSIGNED_BYTE;
+		break;
+	case 16:
+		hwdata->format = GL_RGB;
+		hwdata->type = GL_UNSIGNED_SHORT_5_6_5;
+		break;
+	default:
+		goto free_hwdata;
+	}
 
-	hidden->egl.surface = eglCreateWindowSurface(hidden->egl.dpy, config, (NativeWindowType)SDL_Window, NULL);
-	if (hidden->egl.surface == EGL_NO_SURFACE)
-		goto free_hwsurface;
+	hwdata->tex_w = surface->w;
+	hwdata->tex_h = surface->h;
+	hwdata->pitch = SDL_CalculatePitch(surface);
+	hwdata->pixels = SDL_calloc(surface->h, hwdata->pitch);
+	if (!hwdata->pixels)
+		goto free_hwdata;
 
-	eglMakeCurrent(hidden->egl.dpy, hidden->egl.surface, hidden->egl.surface, hidden->egl.ctx);
+	glGenTextures(1, &hwdata->tex);
+
+	bind_texture(hidden, hwdata);
 
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-	if (compile_fill_shaders(hidden))
-		goto make_current;
-
-	if (compile_blit_shaders(hidden))
-		goto free_fill_shaders;
+	glTexImage2D(GL_TEXTURE_2D, 0, hwdata->format, surface->w, surface->h, 0,
+		     hwdata->format, hwdata->type, NULL);
 
-	if (compile_ckey_shaders(hidden))
-		goto free_blit_shaders;
+	/* SDL_CalculatePitch() pads rows to four bytes */
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-	if (X11_AllocHWSurface(this, screen))
-		goto exit;
+	if (glGetError())
+		goto free_hwdata;
 
-	hidden->gl.dirty = 1;
+	hwdata->dirty_y1 = 0;
+	hwdata->dirty_y2 = surface->h;
 
-	//screen->flags |= SDL_FULLSCREEN | SDL_DOUBLEBUF;
-	this->UpdateRects = X11_UpdateRects;
+	surface->hwdata = hwdata;
+	surface->flags |= SDL_HWSURFACE | SDL_PREALLOC;
 
 	TRACE();
 
 	return 0;
 
- free_blit_shaders:
-	glDeleteProgram(hidden->gl.prog_blit);
- free_fill_shaders:
-	glDeleteProgram(hidden->gl.prog_fill);
- make_current:
-	eglMakeCurrent(hidden->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
- destroy_surface:
-	eglDestroySurface(hidden->egl.dpy, hwdata->surface);
- free_hwsurface:
-	X11_FreeHWSurface(this, screen);
- exit:
-	egl_exit(this);
+ free_hwdata:
+	hwdata_unref(hwdata);
  out:
+	surface->flags &= ~SDL_HWSURFACE;
 	ERROR();
 	return -1;
 }
 
-void X11_DestroyImage(SDL_VideoDevice *this, SDL_Surface *screen)
+static void upload_rows(struct SDL_PrivateVideoData *hidden,
+			struct private_hwdata *hwdata, int w,
+			const Uint8 *pixels, int pitch, int y1, int y2)
+{
+	if (y1 >= y2)
+		return;
+
+	DPRINTF("%p: rows %d-%d\n", hwdata, y1, y2);
+
+	bind_texture(hidden, hwdata);
+
+	/*
+	 * GLES2 has no GL_UNPACK_ROW_LENGTH, so upload whole rows.
+	 * One call for the band is cheaper than one per rectangle.
+	 */
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y1, w, y2 - y1,
+			hwdata->format, hwdata->type,
+			pixels + y1 * pitch);
+}
+
+static void upload_hwdata(SDL_VideoDevice *this, SDL_Surface *surface)
 {
 	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *hwdata = surface->hwdata;
 
+	upload_rows(hidden, hwdata, surface->w, hwdata->pixels, hwdata->pitch,
+		    hwdata->dirty_y1, hwdata->dirty_y2);
+
+	hwdata->dirty_y1 = surface->h;
+	hwdata->dirty_y2 = 0;
+}
+
+/* Lives on texture unit 1, unit 0 holds the indices */
+static int alloc_palette(struct SDL_PrivateVideoData *hidden)
+{
 	TRACE();
 
-	if (screen && screen->hwdata) {
-		hwdata_unref(screen->hwdata);
-		screen->hwdata = NULL;
+	if (hidden->gl.palette_tex)
+		return 0;
+
+	glActiveTexture(GL_TEXTURE1);
+
+	glGenTextures(1, &hidden->gl.palette_tex);
+	glBindTexture(GL_TEXTURE_2D, hidden->gl.palette_tex);
+
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 1, 0,
+		     GL_RGBA, GL_UNSIGNED_BYTE, hidden->gl.palette);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	if (glGetError()) {
+		glDeleteTextures(1, &hidden->gl.palette_tex);
+		hidden->gl.palette_tex = 0;
+		ERROR();
+		return -1;
 	}
 
-	egl_exit(this);
+	hidden->gl.palette_dirty = 0;
+
+	return 0;
+}
+
+static void composite_screen(SDL_VideoDevice *this, SDL_Surface *screen, Uint32 start);
+static void setup_view(SDL_VideoDevice *this, SDL_Surface *screen);
+static int setup_sharp(SDL_VideoDevice *this, SDL_Surface *screen);
+
+/*
+ * Asynchronous present (texture upload mode only).
+ *
+ * The render thread owns the EGL context. UpdateRects copies the dirty
+ * rows into a free frame slot and queues it; when all slots are in
+ * flight the caller blocks until the render thread has swapped one.
+ */
+#define MAX_PRESENT_DEPTH 2
+
+struct present_frame {
+	Uint8 *pixels;
+	int y1, y2;
+};
+
+struct present_state {
+	SDL_VideoDevice *this;
+	SDL_Surface *screen;
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *cond;
+	int depth;
+	int head;
+	int count;
+	int redraw;	/* composite again without a new frame */
+	int quit;
+	struct present_frame frames[MAX_PRESENT_DEPTH];
+};
+
+static Uint32 now_us(void)
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (Uint32) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (Uint32) tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+static void print_stats(const SDL_PresentStats *stats)
+{
+	fprintf(stderr, "SDL present: %u frames, %u missed, %u stalls, "
+		"submit %u us, swap %u us, frame %u us, refresh %u us, interval %d\n",
+		stats->frames, stats->missed, stats->stalls,
+		stats->submit_us, stats->swap_us, stats->frame_us,
+		stats->refresh_us, stats->swap_interval);
+}
+
+static void update_stats(SDL_VideoDevice *this, int interval,
+			 Uint32 start, Uint32 swap, Uint32 end)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct present_state *present = hidden->gl.present;
+	SDL_PresentStats *stats = &hidden->gl.stats;
+	SDL_PresentStats copy;
+
+	if (present)
+		SDL_mutexP(present->lock);
+
+	stats->submit_us = swap - start;
+	stats->swap_us = end - swap;
+	stats->swap_interval = interval;
+
+	if (hidden->gl.last_present_us) {
+		Uint32 refresh = stats->refresh_us;
+		Uint32 frame = end - hidden->gl.last_present_us;
+		Uint32 vblanks = (frame + refresh / 2) / refresh;
+
+		stats->frame_us = frame;
+
+		if (interval > 0) {
+			/* Track the refresh period from presents that hit it */
+			if (vblanks == 1)
+				stats->refresh_us = (refresh * 7 + frame) / 8;
+			/* Longer gaps mean the app was idle, not late */
+			else if (vblanks > 1 && vblanks <= 4)
+				stats->missed += vblanks - 1;
+		}
+	}
+
+	hidden->gl.last_present_us = end;
+	stats->frames++;
+	copy = *stats;
+
+	if (present)
+		SDL_mutexV(present->lock);
+
+	if (hidden->gl.stats_dump && copy.frames % hidden->gl.stats_dump == 0)
+		print_stats(&copy);
+}
+
+static void reset_stats(SDL_VideoDevice *this)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	const char *env;
+
+	SDL_memset(&hidden->gl.stats, 0, sizeof hidden->gl.stats);
+	hidden->gl.stats.refresh_us = 1000000 / 60;
+	hidden->gl.stats.swap_interval = hidden->gl.swap_interval;
+	hidden->gl.last_present_us = 0;
+	hidden->gl.cur_interval = -2;
+
+	env = SDL_getenv("SDL_VIDEO_X11_EGL_STATS");
+	hidden->gl.stats_dump = env ? SDL_atoi(env) : 0;
+}
+
+static int present_thread(void *data)
+{
+	struct present_state *present = data;
+	SDL_VideoDevice *this = present->this;
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	SDL_Surface *screen = present->screen;
+	struct private_hwdata *hwdata = screen->hwdata;
+	Uint32 start;
 
 	TRACE();
+
+	eglMakeCurrent(hidden->egl.dpy, hidden->egl.surface, hidden->egl.surface, hidden->egl.ctx);
+
+	SDL_mutexP(present->lock);
+	for (;;) {
+		struct present_frame *frame;
+
+		while (!present->count && !present->redraw && !present->quit)
+			SDL_CondWait(present->cond, present->lock);
+		if (!present->count && !present->redraw)
+			break;
+
+		present->redraw = 0;
+		if (!present->count) {
+			/* Only the cursor moved, the screen texture is reused */
+			SDL_mutexV(present->lock);
+			composite_screen(this, screen, now_us());
+			SDL_mutexP(present->lock);
+			continue;
+		}
+
+		frame = &present->frames[present->head];
+		SDL_mutexV(present->lock);
+
+		start = now_us();
+		upload_rows(hidden, hwdata, screen->w, frame->pixels, hwdata->pitch,
+			    frame->y1, frame->y2);
+		composite_screen(this, screen, start);
+
+		SDL_mutexP(present->lock);
+		present->head = (present->head + 1) % present->depth;
+		present->count--;
+		SDL_CondSignal(present->cond);
+	}
+	SDL_mutexV(present->lock);
+
+	eglMakeCurrent(hidden->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	TRACE();
+
+	return 0;
 }
 
-int X11_ResizeImage(SDL_VideoDevice *this, SDL_Surface *screen, Uint32 flags)
+static void present_free(struct present_state *present)
 {
-	int retval;
+	int i;
+
+	for (i = 0; i < MAX_PRESENT_DEPTH; i++)
+		SDL_free(present->frames[i].pixels);
+	if (present->cond)
+		SDL_DestroyCond(present->cond);
+	if (present->lock)
+		SDL_DestroyMutex(present->lock);
+	SDL_free(present);
+}
+
+static void present_start(SDL_VideoDevice *this, SDL_Surface *screen)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *hwdata = screen->hwdata;
+	struct present_state *present;
+	const char *env;
+	int depth, i;
 
 	TRACE();
 
-	/* No image when using GL */
-	if (flags & (SDL_OPENGL | SDL_OPENGLES)) {
-		X11_DestroyImage(this, screen);
-		return 0;
+	env = SDL_getenv("SDL_VIDEO_X11_EGL_ASYNC");
+	depth = env ? SDL_atoi(env) : 0;
+	if (depth <= 0 || !hidden->gl.upload)
+		return;
+	if (depth > MAX_PRESENT_DEPTH)
+		depth = MAX_PRESENT_DEPTH;
+
+	present = SDL_calloc(1, sizeof *present);
+	if (!present)
+		goto out;
+
+	present->this = this;
+	present->screen = screen;
+	present->depth = depth;
+
+	for (i = 0; i < depth; i++) {
+		present->frames[i].pixels = SDL_malloc(screen->h * hwdata->pitch);
+		if (!present->frames[i].pixels)
+			goto free_present;
 	}
 
+	present->lock = SDL_CreateMutex();
+	if (!present->lock)
+		goto free_present;
+	present->cond = SDL_CreateCond();
+	if (!present->cond)
+		goto free_present;
+
+	/* Hand the context over to the render thread */
+	eglMakeCurrent(hidden->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	bind_texture(hidden, NULL);
+
+	present->thread = SDL_CreateThread(present_thread, present);
+	if (!present->thread)
+		goto make_current;
+
+	hidden->gl.present = present;
+
 	TRACE();
 
-	/* Already have an image? */
-	if (screen->hwdata)
-		return 0;
+	return;
+
+ make_current:
+	eglMakeCurrent(hidden->egl.dpy, hidden->egl.surface, hidden->egl.surface, hidden->egl.ctx);
+	bind_texture(hidden, NULL);
+ free_present:
+	present_free(present);
+ out:
+	ERROR();
+}
+
+static void present_stop(SDL_VideoDevice *this)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct present_state *present = hidden->gl.present;
 
 	TRACE();
 
-	return setup_screen(this, screen);
+	if (!present)
+		return;
+
+	SDL_mutexP(present->lock);
+	present->quit = 1;
+	SDL_CondSignal(present->cond);
+	SDL_mutexV(present->lock);
+
+	SDL_WaitThread(present->thread, NULL);
+
+	hidden->gl.present = NULL;
+	present_free(present);
+
+	/* Take the context back for cleanup */
+	eglMakeCurrent(hidden->egl.dpy, hidden->egl.surface, hidden->egl.surface, hidden->egl.ctx);
+	bind_texture(hidden, NULL);
+
+	TRACE();
 }
 
-int X11_AllocHWSurface(SDL_VideoDevice *this, SDL_Surface *surface)
+static void present_queue(SDL_VideoDevice *this, SDL_Surface *screen)
 {
 	struct SDL_PrivateVideoData *hidden = this->hidden;
-	struct private_hwdata *hwdata;
-	XVisualInfo vinfo;
-	EGLint attribs[] = {
-		EGL_SURFACE_TYPE, EGL_PIXMAP_BIT,
-		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
-		EGL_NATIVE_VISUAL_ID, 0,
-		EGL_NONE,
-	};
-	static const EGLint image_attribs[] = {
-		EGL_IMAGE_PRESERVED_KHR, EGL_TRUE,
-		EGL_NONE,
-	};
+	struct present_state *present = hidden->gl.present;
+	struct private_hwdata *hwdata = screen->hwdata;
+	struct present_frame *frame;
+	int y1 = hwdata->dirty_y1;
+	int y2 = hwdata->dirty_y2;
 
-	EGLint num_config;
+	TRACE();
+
+	SDL_mutexP(present->lock);
+
+	if (present->count == present->depth)
+		hidden->gl.stats.stalls++;
+	while (present->count == present->depth)
+		SDL_CondWait(present->cond, present->lock);
+
+	frame = &present->frames[(present->head + present->count) % present->depth];
+	SDL_mutexV(present->lock);
+
+	/* The slot is ours until it is queued */
+	if (y1 < y2)
+		SDL_memcpy(frame->pixels + y1 * hwdata->pitch,
+			   hwdata->pixels + y1 * hwdata->pitch,
+			   (y2 - y1) * hwdata->pitch);
+	frame->y1 = y1;
+	frame->y2 = y2;
+
+	SDL_mutexP(present->lock);
+	present->count++;
+	SDL_CondSignal(present->cond);
+	SDL_mutexV(present->lock);
+
+	hwdata->dirty_y1 = screen->h;
+	hwdata->dirty_y2 = 0;
+
+	TRACE();
+}
+
+static int setup_screen(SDL_VideoDevice *this, SDL_Surface *screen)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *hwdata = screen->hwdata;
 	EGLConfig config;
+	Uint32 start;
+	int fresh;
+	int r;
 
 	TRACE();
 
-	switch (surface->format->BitsPerPixel) {
-	case 16:
-		break;
-	default:
+	if (hwdata)
+		return 0;
+
+	/* Display, context and programs are kept across mode changes */
+	fresh = hidden->egl.dpy == EGL_NO_DISPLAY;
+
+ again:
+	if (egl_init(this))
 		goto out;
+
+	hidden->gl.upload = hidden->gl.upload_required;
+
+	/* No paletted EGL surfaces, indices always go through a texture */
+	if (screen->format->BitsPerPixel == 8)
+		hidden->gl.upload = 1;
+
+	config = pick_config(this);
+	if (!config)
+		goto exit;
+
+	hidden->egl.surface = eglCreateWindowSurface(hidden->egl.dpy, config, (NativeWindowType)SDL_Window, NULL);
+	if (hidden->egl.surface == EGL_NO_SURFACE)
+		goto exit;
+
+	if (!eglMakeCurrent(hidden->egl.dpy, hidden->egl.surface, hidden->egl.surface, hidden->egl.ctx)) {
+		/* The new window doesn't suit the old context, start over */
+		if (!fresh) {
+			egl_exit(this);
+			fresh = 1;
+			goto again;
+		}
+		goto exit;
+	}
+
+	reset_stats(this);
+
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	start = now_us();
+
+	if (!hidden->gl.cache_dir)
+		program_cache_init(hidden);
+
+	if (compile_fill_shaders(hidden))
+		goto exit;
+
+	if (compile_blit_shaders(hidden))
+		goto exit;
+
+	if (compile_ckey_shaders(hidden))
+		goto exit;
+
+	if (screen->format->BitsPerPixel == 8) {
+		if (compile_pal_shaders(hidden))
+			goto exit;
+		if (alloc_palette(hidden))
+			goto exit;
+	}
+
+	if (hidden->gl.stats_dump)
+		fprintf(stderr, "SDL present: shaders ready in %u us, %d from cache\n",
+			now_us() - start, hidden->gl.cache_hits);
+
+	if (!hidden->gl.upload &&
+	    !has_extension((const char *) glGetString(GL_EXTENSIONS), "GL_OES_EGL_image")) {
+		hidden->gl.upload = 1;
+		hidden->gl.upload_required = 1;
+	}
+
+	setup_view(this, screen);
+	if (setup_sharp(this, screen))
+		ERROR();	/* plain bilinear then */
+
+	if (hidden->gl.upload) {
+		if (alloc_upload_hwdata(this, screen))
+			goto exit;
+	} else {
+		if (alloc_pixmap_surface(this, screen))
+			goto exit;
+	}
+
+	hidden->gl.dirty = 1;
+
+	//screen->flags |= SDL_FULLSCREEN | SDL_DOUBLEBUF;
+	this->UpdateRects = X11_UpdateRects;
+
+	present_start(this, screen);
+
+	TRACE();
+
+	return 0;
+
+ exit:
+	/* Programs go with the context; a kept one also holds HW surfaces */
+	if (fresh)
+		egl_exit(this);
+	else
+		X11_ReleaseImage(this, screen);
+ out:
+	ERROR();
+	return -1;
+}
+
+/* Drop everything tied to the current mode, leaves the context current */
+static void release_screen(SDL_VideoDevice *this, SDL_Surface *screen)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+
+	TRACE();
+
+	present_stop(this);
+
+	if (hidden->gl.stats_dump && hidden->gl.stats.frames)
+		print_stats(&hidden->gl.stats);
+	hidden->gl.stats_dump = 0;
+
+	if (screen && screen->hwdata) {
+		hwdata_unref(screen->hwdata);
+		screen->hwdata = NULL;
 	}
 
+	/* Shown again by SDL_SetVideoMode() if the next mode composites */
+	SDL_free(hidden->gl.cursor_image);
+	hidden->gl.cursor_image = NULL;
+
+	TRACE();
+}
+
+/* The window is about to go away, but a new mode will follow */
+void X11_ReleaseImage(SDL_VideoDevice *this, SDL_Surface *screen)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+
+	TRACE();
+
 	if (hidden->egl.dpy == EGL_NO_DISPLAY)
-		goto out;
+		return;
 
-	hwdata = hwdata_alloc(this);
-	if (!hwdata)
-		goto out;
+	release_screen(this, screen);
 
-	if (!XMatchVisualInfo(SDL_Display, SDL_Screen, surface->format->BitsPerPixel, TrueColor, &vinfo))
-		goto free_hwdata;
+	eglMakeCurrent(hidden->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
-	attribs[5] = vinfo.visualid;
+	if (hidden->egl.surface != EGL_NO_SURFACE) {
+		eglDestroySurface(hidden->egl.dpy, hidden->egl.surface);
+		hidden->egl.surface = EGL_NO_SURFACE;
+	}
 
-	if (!eglChooseConfig(hidden->egl.dpy, attribs, &config, 1, &num_config))
-		goto free_hwdata;
+	TRACE();
+}
 
-	DPRINTF("%p: w=%d h=%d BitsPerPixel=%d BytesPerPixel=%d\n", surface, surface->w, surface->h,
-		surface->format->BitsPerPixel, surface->format->BytesPerPixel);
+void X11_DestroyImage(SDL_VideoDevice *this, SDL_Surface *screen)
+{
+	TRACE();
 
-	hwdata->pixmap = XCreatePixmap(SDL_Display, SDL_Root, surface->w, surface->h, surface->format->BitsPerPixel);
-	if (hwdata->pixmap == None)
-		goto free_hwdata;
+	release_screen(this, screen);
 
-	hwdata->surface = eglCreatePixmapSurface(hidden->egl.dpy, config, (NativePixmapType) hwdata->pixmap, NULL);
-	if (hwdata->surface == EGL_NO_SURFACE)
-		goto free_hwdata;
+	egl_exit(this);
 
-	hwdata->image = eglCreateImageKHR(hidden->egl.dpy, EGL_NO_CONTEXT,
-					  EGL_NATIVE_PIXMAP_KHR, (EGLClientBuffer) hwdata->pixmap, image_attribs);
-	if (hwdata->image == EGL_NO_IMAGE_KHR)
-		goto free_hwdata;
+	TRACE();
+}
 
-	glGenFramebuffers(1, &hwdata->fbo);
-	glGenTextures(1, &hwdata->tex);
+/* Whether screens can be composited at all, which emulated 8bpp modes
+   rely on: there is no other way to show them */
+int X11_CanCompositeImage(SDL_VideoDevice *this)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
 
-	bind_texture(hidden, hwdata);
-	bind_framebuffer(hidden, hwdata);
+	if (hidden->egl.dpy == EGL_NO_DISPLAY && !hidden->egl.unusable &&
+	    egl_init(this))
+		hidden->egl.unusable = 1;
 
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return !hidden->egl.unusable;
+}
 
-	glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, hwdata->image);
+int X11_ResizeImage(SDL_VideoDevice *this, SDL_Surface *screen, Uint32 flags)
+{
+	int retval;
 
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-			       GL_TEXTURE_2D, hwdata->tex, 0);
+	TRACE();
+
+	/* No image when using GL */
+	if (flags & (SDL_OPENGL | SDL_OPENGLES)) {
+		X11_DestroyImage(this, screen);
+		return 0;
+	}
+
+	TRACE();
+
+	/* Already have an image? */
+	if (screen->hwdata) {
+		struct SDL_PrivateVideoData *hidden = this->hidden;
+		struct private_hwdata *hwdata = screen->hwdata;
+
+		if (hwdata->tex_w == screen->w && hwdata->tex_h == screen->h &&
+		    hidden->gl.screen_bpp == screen->format->BitsPerPixel &&
+		    hidden->gl.screen_flags == flags)
+			return 0;
+
+		/* Same window, context and programs; new screen texture */
+		X11_ReleaseImage(this, screen);
+	}
+
+	TRACE();
+
+	if (setup_screen(this, screen))
+		return -1;
+
+	this->hidden->gl.screen_bpp = screen->format->BitsPerPixel;
+	this->hidden->gl.screen_flags = flags;
+
+	return 0;
+}
+
+int X11_AllocHWSurface(SDL_VideoDevice *this, SDL_Surface *surface)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+
+	TRACE();
 
-	glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
+	switch (surface->format->BitsPerPixel) {
+	case 16:
+		break;
+	default:
+		goto out;
+	}
 
-	set_finish_hwdata(hwdata, hwdata);
+	if (hidden->egl.dpy == EGL_NO_DISPLAY)
+		goto out;
 
-	surface->hwdata = hwdata;
-	surface->flags |= SDL_HWSURFACE | SDL_PREALLOC;
+	/* Off-screen surfaces stay in software when streaming */
+	if (hidden->gl.upload)
+		goto out;
 
-	TRACE();
+	if (hidden->gl.use_atlas &&
+	    surface->w <= ATLAS_MAX_ITEM && surface->h <= ATLAS_MAX_ITEM &&
+	    !atlas_alloc(this, surface))
+		return 0;
 
-	return 0;
+	return alloc_pixmap_surface(this, surface);
 
- free_hwdata:
-	hwdata_unref(hwdata);
  out:
 	surface->flags &= ~SDL_HWSURFACE;
 	ERROR();
@@ -828,23 +2160,70 @@ void X11_FreeHWSurface(SDL_VideoDevice *this, SDL_Surface *surface)
 }
 
 int X11_LockHWSurface(SDL_VideoDevice *this, SDL_Surface *surface)
+{
+	return X11_LockHWSurfaceEx(this, surface, SDL_LOCK_READ | SDL_LOCK_WRITE, NULL);
+}
+
+int X11_LockHWSurfaceEx(SDL_VideoDevice *this, SDL_Surface *surface,
+			Uint32 flags, const SDL_Rect *rect)
 {
 	struct SDL_PrivateVideoData *hidden = this->hidden;
 	struct private_hwdata *hwdata = surface->hwdata;
-	static const EGLint attribs[] = {
+	struct atlas_page *page = hwdata->page;
+	EGLint attribs[] = {
 		EGL_MAP_PRESERVE_PIXELS_KHR, EGL_TRUE,
+		EGL_LOCK_USAGE_HINT_KHR, 0,
 		EGL_NONE,
 	};
 	EGLint pointer, pitch;
+	Uint8 *pixels;
 
 	TRACE();
 
-	if (hwdata->finish_hwdata) {
+	if (hidden->gl.upload) {
+		surface->pixels = hwdata->pixels;
+		surface->pitch = hwdata->pitch;
+
+		/* UpdateRects tells us what to upload, unless the rect does */
+		if (rect && (flags & SDL_LOCK_WRITE) && rect->w && rect->h) {
+			if (rect->y < hwdata->dirty_y1)
+				hwdata->dirty_y1 = rect->y;
+			if (rect->y + rect->h > hwdata->dirty_y2)
+				hwdata->dirty_y2 = rect->y + rect->h;
+		}
+		return 0;
+	}
+
+	/* Another surface in the same page already has it mapped */
+	if (page && page->locks) {
+		pixels = page->pixels;
+		pitch = page->pitch;
+		goto mapped;
+	}
+
+	hwdata = backing(hwdata);
+
+	/*
+	 * Queued blits that only read from the surface can't disturb a
+	 * read-only lock. Anything rendering into it must finish first,
+	 * discarding the contents doesn't cancel the queued writes.
+	 */
+	if (hwdata->finish_hwdata &&
+	    (flags & SDL_LOCK_WRITE || hwdata->finish_hwdata == hwdata)) {
 		bind_framebuffer(hidden, hwdata->finish_hwdata);
 		glFinish();
 		set_finish_hwdata(hwdata, NULL);
 	}
 
+	/* The page is shared, only a whole surface may be thrown away */
+	if (flags & SDL_LOCK_DISCARD && !page &&
+	    (!rect || (rect->w == surface->w && rect->h == surface->h)))
+		attribs[1] = EGL_FALSE;
+	if (flags & SDL_LOCK_READ)
+		attribs[3] |= EGL_READ_SURFACE_BIT_KHR;
+	if (flags & SDL_LOCK_WRITE)
+		attribs[3] |= EGL_WRITE_SURFACE_BIT_KHR;
+
 	if (!eglLockSurfaceKHR(hidden->egl.dpy, hwdata->surface, attribs))
 		goto out;
 
@@ -854,11 +2233,24 @@ int X11_LockHWSurface(SDL_VideoDevice *this, SDL_Surface *surface)
 	if (!eglQuerySurface(hidden->egl.dpy, hwdata->surface, EGL_BITMAP_PITCH_KHR, &pitch))
 		goto unlock;
 
-	surface->pixels = (void *) pointer;
+	pixels = (void *) pointer;
+
+	if (page) {
+		page->pixels = pixels;
+		page->pitch = pitch;
+	}
+
+ mapped:
+	if (page)
+		page->locks++;
+
+	hwdata = surface->hwdata;
+	surface->pixels = pixels + hwdata->y * pitch +
+		hwdata->x * surface->format->BytesPerPixel;
 	surface->pitch = pitch;
 
-	/* Can't know whether it's a read or write :( */
-	if (surface == this->screen)
+	/* Read-only locks leave the display alone */
+	if (surface == this->screen && (flags & SDL_LOCK_WRITE))
 		hidden->gl.dirty = 1;
 
 	DPRINTF("%p:pixels=%p, pitch=%p\n", surface, surface->pixels, surface->pitch);
@@ -883,7 +2275,8 @@ void X11_UnlockHWSurface(SDL_VideoDevice *this, SDL_Surface *surface)
 
 	DPRINTF("%p:pixels=%p, pitch=%p\n", surface, surface->pixels, surface->pitch);
 
-	eglUnlockSurfaceKHR(hidden->egl.dpy, hwdata->surface);
+	if (!hidden->gl.upload && (!hwdata->page || --hwdata->page->locks == 0))
+		eglUnlockSurfaceKHR(hidden->egl.dpy, backing(hwdata)->surface);
 
 	surface->pixels = NULL;
 	surface->pitch = 0;
@@ -939,19 +2332,11 @@ static int X11_HWBlit(SDL_Surface *src, SDL_Rect *srcrect,
 		x2, y1,
 		x2, y2,
 	};
-	x1 = (GLfloat) srcrect->x / src->w;
-	y1 = (GLfloat) srcrect->y / src->h;
-	x2 = (GLfloat) (srcrect->x + srcrect->w) / src->w;
-	y2 = (GLfloat) (srcrect->y + srcrect->h) / src->h;
-	const GLfloat texcoords[] = {
-		x1, y1,
-		x1, y2,
-		x2, y1,
-		x2, y2,
-	};
+	GLfloat texcoords[8];
 	SDL_VideoDevice *this = dsthwdata->this;
 	struct SDL_PrivateVideoData *hidden = this->hidden;
 	struct rgba_color color;
+	GLenum min_filter, mag_filter;
 	GLuint prog;
 
 	TRACE();
@@ -966,14 +2351,53 @@ static int X11_HWBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	bind_texture(hidden, srchwdata);
 	bind_framebuffer(hidden, dsthwdata);
 
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-			srcrect->w > dstrect->w || srcrect->h > dstrect->h ?
-			GL_LINEAR : GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-			srcrect->w < dstrect->w || srcrect->h < dstrect->h ?
-			GL_LINEAR : GL_NEAREST);
+	switch (this->stretch_filter) {
+	case SDL_STRETCH_NEAREST:
+		min_filter = mag_filter = GL_NEAREST;
+		break;
+	case SDL_STRETCH_LINEAR:
+		min_filter = mag_filter = GL_LINEAR;
+		break;
+	default:
+		min_filter = srcrect->w > dstrect->w || srcrect->h > dstrect->h ?
+			GL_LINEAR : GL_NEAREST;
+		mag_filter = srcrect->w < dstrect->w || srcrect->h < dstrect->h ?
+			GL_LINEAR : GL_NEAREST;
+		break;
+	}
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+
+	x1 = (GLfloat) (srchwdata->x + srcrect->x) / srchwdata->tex_w;
+	y1 = (GLfloat) (srchwdata->y + srcrect->y) / srchwdata->tex_h;
+	x2 = (GLfloat) (srchwdata->x + srcrect->x + srcrect->w) / srchwdata->tex_w;
+	y2 = (GLfloat) (srchwdata->y + srcrect->y + srcrect->h) / srchwdata->tex_h;
+
+	/*
+	 * Bilinear taps half a texel past the quad, which in an atlas is the
+	 * gap or a neighbour. Pull the edges of the surface in by that much,
+	 * like GL_CLAMP_TO_EDGE does for a texture of its own.
+	 */
+	if (srchwdata->page &&
+	    (min_filter == GL_LINEAR || mag_filter == GL_LINEAR)) {
+		GLfloat lo_x = (srchwdata->x + 0.5f) / srchwdata->tex_w;
+		GLfloat lo_y = (srchwdata->y + 0.5f) / srchwdata->tex_h;
+		GLfloat hi_x = (srchwdata->x + src->w - 0.5f) / srchwdata->tex_w;
+		GLfloat hi_y = (srchwdata->y + src->h - 0.5f) / srchwdata->tex_h;
+
+		x1 = SDL_max(x1, lo_x);
+		y1 = SDL_max(y1, lo_y);
+		x2 = SDL_min(x2, hi_x);
+		y2 = SDL_min(y2, hi_y);
+	}
 
-	glViewport(0, 0, dst->w, dst->h);
+	texcoords[0] = x1; texcoords[1] = y1;
+	texcoords[2] = x1; texcoords[3] = y2;
+	texcoords[4] = x2; texcoords[5] = y1;
+	texcoords[6] = x2; texcoords[7] = y2;
+
+	/* The viewport also keeps atlas neighbours safe */
+	glViewport(dsthwdata->x, dsthwdata->y, dst->w, dst->h);
 
 	if (src->flags & SDL_SRCCOLORKEY) {
 		pixel_to_color(src->format, src->format->colorkey, &color);
@@ -1004,107 +2428,607 @@ static int X11_HWBlit(SDL_Surface *src, SDL_Rect *srcrect,
 	if (glGetError())
 		ERROR();
 
-	TRACE();
+	TRACE();
+
+	return 0;
+}
+
+int X11_CheckHWBlit(SDL_VideoDevice *this, SDL_Surface *src, SDL_Surface *dst)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *srchwdata = src->hwdata;
+	struct private_hwdata *dsthwdata = dst->hwdata;
+
+	TRACE();
+
+	/* FIXME use a temp buffer? */
+	if (src == dst)
+		goto out;
+
+	if (!srchwdata || !dsthwdata)
+		goto out;
+
+	/* Can't sample the texture being rendered to */
+	if (backing(srchwdata) == backing(dsthwdata))
+		goto out;
+
+	if (hidden->gl.upload)
+		goto out;
+
+	/* Don't mix SW and HW access */
+	if (src->locked || dst->locked)
+		goto out;
+	if ((srchwdata->page && srchwdata->page->locks) ||
+	    (dsthwdata->page && dsthwdata->page->locks))
+		goto out;
+
+	src->flags |= SDL_HWACCEL;
+	src->map->hw_blit = X11_HWBlit;
+
+	TRACE();
+
+	return 0;
+
+ out:
+	ERROR();
+	return -1;
+}
+
+int X11_CheckHWFill(SDL_VideoDevice *this, SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *hwdata = dst->hwdata;
+
+	TRACE();
+
+	/* Don't mix SW and HW access */
+	if (dst->locked)
+		goto out;
+	if (hwdata && hwdata->page && hwdata->page->locks)
+		goto out;
+
+	/* The pixels in memory are authoritative when streaming */
+	if (hidden->gl.upload)
+		goto out;
+
+	TRACE();
+
+	return 1;
+
+ out:
+	ERROR();
+	return 0;
+}
+
+int X11_FillHWRect(SDL_VideoDevice *this, SDL_Surface *dst, SDL_Rect *dstrect, Uint32 pixel)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *dsthwdata = dst->hwdata;
+	GLfloat x1 = 2.0f * dstrect->x / dst->w - 1.0f;
+	GLfloat y1 = 2.0f * dstrect->y / dst->h - 1.0f;
+	GLfloat x2 = 2.0f * (dstrect->x + dstrect->w) / dst->w - 1.0f;
+	GLfloat y2 = 2.0f * (dstrect->y + dstrect->h) / dst->h - 1.0f;
+	const GLfloat verts[] = {
+		x1, y1,
+		x1, y2,
+		x2, y1,
+		x2, y2,
+	};
+	struct rgba_color color;
+
+	TRACE();
+
+	pixel_to_color(dst->format, pixel, &color);
+
+	DPRINTF("0x%08x -> %p:%dx%d+%d+%d\n", color, dst, dstrect->w, dstrect->h, dstrect->x, dstrect->y);
+
+	if (glGetError())
+		ERROR();
+
+	bind_framebuffer(hidden, dsthwdata);
+
+	glViewport(dsthwdata->x, dsthwdata->y, dst->w, dst->h);
+
+	/* glClear() ignores the viewport, it would hit the whole page */
+	if (dstrect->w == dst->w && dstrect->h == dst->h && !dsthwdata->page) {
+		DPRINTF("CLEAR %f %f %f %f\n", color.r, color.g, color.b, color.a);
+		glClearColor(color.r, color.g, color.b, color.a);
+		glClear(GL_COLOR_BUFFER_BIT);
+	} else {
+		draw_quad(verts, NULL, &color, hidden->gl.prog_fill);
+	}
+
+	set_finish_hwdata(dsthwdata, dsthwdata);
+
+	if (dst == this->screen)
+		hidden->gl.dirty = 1;
+
+	if (glGetError())
+		ERROR();
+
+	TRACE();
+
+	return 0;
+}
+
+/*
+ * YUV overlays: the planes live in system memory, get uploaded as
+ * luminance textures on display and are converted and scaled by
+ * the shader straight into the screen texture.
+ */
+struct private_yuvhwdata {
+	GLuint tex[3];
+	unsigned int serial;	/* context the textures belong to */
+	int dirty;
+	Uint16 pitches[3];
+	Uint8 *planes[3];
+	Uint8 *pixels;
+};
+
+static int X11_LockImageYUVOverlay(SDL_VideoDevice *this, SDL_Overlay *overlay)
+{
+	return 0;
+}
+
+static void X11_UnlockImageYUVOverlay(SDL_VideoDevice *this, SDL_Overlay *overlay)
+{
+	/* Can't know whether it's a read or write :( */
+	overlay->hwdata->dirty = 1;
+}
+
+static void upload_yuv_planes(SDL_Overlay *overlay)
+{
+	struct private_yuvhwdata *yuvdata = overlay->hwdata;
+	int cw = (overlay->w + 1) / 2;
+	int ch = (overlay->h + 1) / 2;
+	int i;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (i = 0; i < overlay->planes; i++) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, yuvdata->tex[i]);
+		if (i == 0)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, overlay->w, overlay->h,
+					GL_LUMINANCE, GL_UNSIGNED_BYTE, overlay->pixels[i]);
+		else if (overlay->format == SDL_NV12_OVERLAY)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cw, ch,
+					GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, overlay->pixels[i]);
+		else
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cw, ch,
+					GL_LUMINANCE, GL_UNSIGNED_BYTE, overlay->pixels[i]);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	yuvdata->dirty = 0;
+}
+
+static int X11_DisplayImageYUVOverlay(SDL_VideoDevice *this, SDL_Overlay *overlay,
+				      SDL_Rect *src, SDL_Rect *dst)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_yuvhwdata *yuvdata = overlay->hwdata;
+	SDL_Surface *screen = this->screen;
+	struct private_hwdata *dsthwdata = screen->hwdata;
+	GLfloat x1 = 2.0f * dst->x / screen->w - 1.0f;
+	GLfloat y1 = 2.0f * dst->y / screen->h - 1.0f;
+	GLfloat x2 = 2.0f * (dst->x + dst->w) / screen->w - 1.0f;
+	GLfloat y2 = 2.0f * (dst->y + dst->h) / screen->h - 1.0f;
+	const GLfloat verts[] = {
+		x1, y1,
+		x1, y2,
+		x2, y1,
+		x2, y2,
+	};
+	x1 = (GLfloat) src->x / overlay->w;
+	y1 = (GLfloat) src->y / overlay->h;
+	x2 = (GLfloat) (src->x + src->w) / overlay->w;
+	y2 = (GLfloat) (src->y + src->h) / overlay->h;
+	const GLfloat texcoords[] = {
+		x1, y1,
+		x1, y2,
+		x2, y1,
+		x2, y2,
+	};
+	static const struct rgba_color color = { 1.0f, 1.0f, 1.0f, 1.0f };
+	GLuint prog;
+	GLenum filter;
+	int i;
+
+	TRACE();
+
+	if (!dsthwdata || screen->locked) {
+		SDL_SetError("Screen is not available for overlays");
+		return -1;
+	}
+
+	if (yuvdata->serial != hidden->egl.serial) {
+		SDL_SetError("Overlay textures were lost with the GL context");
+		return -1;
+	}
+
+	if (glGetError())
+		ERROR();
+
+	/* Units 1 and 2 are only used here; leave unit 0 unbound afterwards */
+	bind_texture(hidden, NULL);
+	bind_framebuffer(hidden, dsthwdata);
+
+	if (yuvdata->dirty)
+		upload_yuv_planes(overlay);
+
+	filter = src->w == dst->w && src->h == dst->h ? GL_NEAREST : GL_LINEAR;
+	for (i = 0; i < overlay->planes; i++) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, yuvdata->tex[i]);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	}
+
+	prog = overlay->format == SDL_NV12_OVERLAY ?
+		hidden->gl.prog_nv12 : hidden->gl.prog_yuv;
+
+	/* Planes are Y, U, V for IYUV but Y, V, U for YV12 */
+	glUseProgram(prog);
+	glUniform1i(glGetUniformLocation(prog, "tex_y"), 0);
+	if (overlay->format == SDL_YV12_OVERLAY) {
+		glUniform1i(glGetUniformLocation(prog, "tex_u"), 2);
+		glUniform1i(glGetUniformLocation(prog, "tex_v"), 1);
+	} else {
+		glUniform1i(glGetUniformLocation(prog, "tex_u"), 1);
+		if (overlay->planes > 2)
+			glUniform1i(glGetUniformLocation(prog, "tex_v"), 2);
+	}
+
+	glViewport(0, 0, screen->w, screen->h);
+
+	draw_quad(verts, texcoords, &color, prog);
+
+	for (i = overlay->planes - 1; i >= 0; i--) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	set_finish_hwdata(dsthwdata, dsthwdata);
+	hidden->gl.dirty = 1;
+
+	if (glGetError())
+		ERROR();
+
+	SDL_UpdateRects(screen, 1, dst);
+
+	TRACE();
+
+	return 0;
+}
+
+/*
+ * The textures belong to the context that was current when the overlay
+ * was made.  Once that context is gone the names may already be reused
+ * by a newer one, so they are only forgotten then.
+ */
+static void free_yuv_textures(struct SDL_PrivateVideoData *hidden,
+			      SDL_Overlay *overlay)
+{
+	struct private_yuvhwdata *yuvdata = overlay->hwdata;
+
+	if (hidden->egl.dpy != EGL_NO_DISPLAY &&
+	    yuvdata->serial == hidden->egl.serial &&
+	    eglGetCurrentContext() == hidden->egl.ctx)
+		glDeleteTextures(overlay->planes, yuvdata->tex);
+
+	SDL_memset(yuvdata->tex, 0, sizeof yuvdata->tex);
+}
+
+static void X11_FreeImageYUVOverlay(SDL_VideoDevice *this, SDL_Overlay *overlay)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_yuvhwdata *yuvdata = overlay->hwdata;
+
+	TRACE();
+
+	if (!yuvdata)
+		return;
+
+	free_yuv_textures(hidden, overlay);
+
+	SDL_free(yuvdata->pixels);
+	SDL_free(yuvdata);
+	overlay->hwdata = NULL;
 }
 
-int X11_CheckHWBlit(SDL_VideoDevice *this, SDL_Surface *src, SDL_Surface *dst)
+static struct private_yuvhwfuncs x11_image_yuvfuncs = {
+	X11_LockImageYUVOverlay,
+	X11_UnlockImageYUVOverlay,
+	X11_DisplayImageYUVOverlay,
+	X11_FreeImageYUVOverlay
+};
+
+static SDL_Overlay *create_image_yuv_overlay(SDL_VideoDevice *this, int width, int height,
+					      Uint32 format)
 {
 	struct SDL_PrivateVideoData *hidden = this->hidden;
-	struct private_hwdata *srchwdata = src->hwdata;
-	struct private_hwdata *dsthwdata = dst->hwdata;
+	SDL_Surface *screen = this->screen;
+	SDL_Overlay *overlay;
+	struct private_yuvhwdata *yuvdata;
+	int cw = (width + 1) / 2;
+	int ch = (height + 1) / 2;
+	int size, i;
 
 	TRACE();
 
-	/* FIXME use a temp buffer? */
-	if (src == dst)
+	/* Needs to render into the screen texture */
+	if (!screen || !screen->hwdata || hidden->gl.upload)
 		goto out;
 
-	if (!srchwdata || !dsthwdata)
+	switch (format) {
+	case SDL_YV12_OVERLAY:
+	case SDL_IYUV_OVERLAY:
+		if (compile_yuv_shaders(hidden))
+			goto out;
+		break;
+	case SDL_NV12_OVERLAY:
+		if (compile_nv12_shaders(hidden))
+			goto out;
+		break;
+	default:
 		goto out;
+	}
 
-	/* Don't mix SW and HW access */
-	if (src->locked || dst->locked)
+	overlay = SDL_calloc(1, sizeof *overlay);
+	if (!overlay)
 		goto out;
 
-	src->flags |= SDL_HWACCEL;
-	src->map->hw_blit = X11_HWBlit;
+	yuvdata = SDL_calloc(1, sizeof *yuvdata);
+	if (!yuvdata)
+		goto free_overlay;
+
+	overlay->format = format;
+	overlay->w = width;
+	overlay->h = height;
+	overlay->hwfuncs = &x11_image_yuvfuncs;
+	overlay->hwdata = yuvdata;
+	overlay->hw_overlay = 1;
+	overlay->pitches = yuvdata->pitches;
+	overlay->pixels = yuvdata->planes;
+
+	yuvdata->pitches[0] = width;
+	if (format == SDL_NV12_OVERLAY) {
+		overlay->planes = 2;
+		yuvdata->pitches[1] = cw * 2;
+	} else {
+		overlay->planes = 3;
+		yuvdata->pitches[1] = cw;
+		yuvdata->pitches[2] = cw;
+	}
+
+	size = width * height + 2 * cw * ch;
+	yuvdata->pixels = SDL_malloc(size);
+	if (!yuvdata->pixels)
+		goto free_yuvdata;
+
+	/* Black */
+	SDL_memset(yuvdata->pixels, 0x10, width * height);
+	SDL_memset(yuvdata->pixels + width * height, 0x80, 2 * cw * ch);
+
+	yuvdata->planes[0] = yuvdata->pixels;
+	yuvdata->planes[1] = yuvdata->planes[0] + width * height;
+	if (overlay->planes > 2)
+		yuvdata->planes[2] = yuvdata->planes[1] + cw * ch;
+
+	if (glGetError())
+		ERROR();
+
+	glGenTextures(overlay->planes, yuvdata->tex);
+	yuvdata->serial = hidden->egl.serial;
+
+	bind_texture(hidden, NULL);
+
+	for (i = 0; i < overlay->planes; i++) {
+		glBindTexture(GL_TEXTURE_2D, yuvdata->tex[i]);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		if (i == 0)
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0,
+				     GL_LUMINANCE, GL_UNSIGNED_BYTE, NULL);
+		else if (format == SDL_NV12_OVERLAY)
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, cw, ch, 0,
+				     GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, NULL);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, cw, ch, 0,
+				     GL_LUMINANCE, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (glGetError())
+		goto free_textures;
+
+	yuvdata->dirty = 1;
 
 	TRACE();
 
-	return 0;
+	return overlay;
 
+ free_textures:
+	free_yuv_textures(hidden, overlay);
+	SDL_free(yuvdata->pixels);
+ free_yuvdata:
+	SDL_free(yuvdata);
+ free_overlay:
+	SDL_free(overlay);
  out:
 	ERROR();
-	return -1;
+	return NULL;
 }
 
-int X11_CheckHWFill(SDL_VideoDevice *this, SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color)
+SDL_Overlay *X11_CreateImageYUVOverlay(SDL_VideoDevice *this, int width, int height,
+				       Uint32 format, SDL_Surface *display)
 {
-	struct SDL_PrivateVideoData *hidden = this->hidden;
-	struct private_hwdata *hwdata = dst->hwdata;
+	SDL_Overlay *overlay;
 
 	TRACE();
 
-	/* Don't mix SW and HW access */
-	if (dst->locked)
-		goto out;
+	overlay = create_image_yuv_overlay(this, width, height, format);
+#if SDL_VIDEO_DRIVER_X11_XV
+	if (!overlay && !this->screen->hwdata)
+		overlay = X11_CreateYUVOverlay(this, width, height, format, display);
+#endif
+
+	return overlay;
+}
+
+int X11_SetImageColors(SDL_VideoDevice *this, int firstcolor, int ncolors, SDL_Color *colors)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct present_state *present = hidden->gl.present;
+	Uint8 *entry = &hidden->gl.palette[firstcolor * 4];
+	int i;
 
 	TRACE();
 
+	if (present)
+		SDL_mutexP(present->lock);
+	for (i = 0; i < ncolors; i++) {
+		entry[0] = colors[i].r;
+		entry[1] = colors[i].g;
+		entry[2] = colors[i].b;
+		entry[3] = 0xff;
+		entry += 4;
+	}
+	hidden->gl.palette_dirty = 1;
+	if (present)
+		SDL_mutexV(present->lock);
+
+	/* Like a hardware palette, the change shows up immediately */
+	if (this->screen && this->screen->hwdata) {
+		hidden->gl.dirty = 1;
+		X11_UpdateRects(this, 0, NULL);
+	}
+
 	return 1;
+}
 
- out:
-	ERROR();
-	return 0;
+/*
+ * Cursor changes come from whichever thread pumps events, which may not
+ * own the context and may run in the middle of the app's drawing: only
+ * the render thread is asked to redraw now, otherwise the cursor shows
+ * up with the next UpdateRects.
+ */
+static void cursor_changed(SDL_VideoDevice *this)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct present_state *present = hidden->gl.present;
+
+	if (present) {
+		SDL_mutexP(present->lock);
+		present->redraw = 1;
+		SDL_CondBroadcast(present->cond);
+		SDL_mutexV(present->lock);
+	} else
+		hidden->gl.dirty = 1;
 }
 
-int X11_FillHWRect(SDL_VideoDevice *this, SDL_Surface *dst, SDL_Rect *dstrect, Uint32 pixel)
+int X11_SetImageCursor(SDL_VideoDevice *this, const Uint8 *image,
+		       int w, int h, int hot_x, int hot_y)
 {
 	struct SDL_PrivateVideoData *hidden = this->hidden;
-	struct private_hwdata *dsthwdata = dst->hwdata;
-	GLfloat x1 = 2.0f * dstrect->x / dst->w - 1.0f;
-	GLfloat y1 = 2.0f * dstrect->y / dst->h - 1.0f;
-	GLfloat x2 = 2.0f * (dstrect->x + dstrect->w) / dst->w - 1.0f;
-	GLfloat y2 = 2.0f * (dstrect->y + dstrect->h) / dst->h - 1.0f;
-	const GLfloat verts[] = {
-		x1, y1,
-		x1, y2,
-		x2, y1,
-		x2, y2,
-	};
-	struct rgba_color color;
+	struct present_state *present = hidden->gl.present;
+	Uint8 *copy = NULL;
+	Uint8 *old;
+	int changed;
 
 	TRACE();
 
-	pixel_to_color(dst->format, pixel, &color);
+	/* Not compositing, the X server draws the cursor */
+	if (!this->screen || !this->screen->hwdata)
+		return 0;
 
-	DPRINTF("0x%08x -> %p:%dx%d+%d+%d\n", color, dst, dstrect->w, dstrect->h, dstrect->x, dstrect->y);
+	if (image) {
+		copy = SDL_malloc(w * h * 4);
+		if (!copy) {
+			SDL_OutOfMemory();
+			return 0;
+		}
+		SDL_memcpy(copy, image, w * h * 4);
+	}
 
-	if (glGetError())
-		ERROR();
+	if (present)
+		SDL_mutexP(present->lock);
+	old = hidden->gl.cursor_image;
+	hidden->gl.cursor_image = copy;
+	hidden->gl.cursor_w = w;
+	hidden->gl.cursor_h = h;
+	hidden->gl.cursor_hot_x = hot_x;
+	hidden->gl.cursor_hot_y = hot_y;
+	hidden->gl.cursor_dirty = 1;
+	if (present)
+		SDL_mutexV(present->lock);
 
-	bind_framebuffer(hidden, dsthwdata);
+	changed = copy || old;
+	SDL_free(old);
 
-	glViewport(0, 0, dst->w, dst->h);
+	if (changed)
+		cursor_changed(this);
 
-	if (dstrect->w == dst->w && dstrect->h == dst->h) {
-		DPRINTF("CLEAR %f %f %f %f\n", color.r, color.g, color.b, color.a);
-		glClearColor(color.r, color.g, color.b, color.a);
-		glClear(GL_COLOR_BUFFER_BIT);
-	} else {
-		draw_quad(verts, NULL, &color, hidden->gl.prog_fill);
+	return 1;
+}
+
+void X11_MoveImageCursor(SDL_VideoDevice *this, int x, int y)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct present_state *present = hidden->gl.present;
+	int visible;
+
+	if (present)
+		SDL_mutexP(present->lock);
+	hidden->gl.cursor_x = x;
+	hidden->gl.cursor_y = y;
+	visible = hidden->gl.cursor_image != NULL;
+	if (present)
+		SDL_mutexV(present->lock);
+
+	if (visible && this->screen && this->screen->hwdata)
+		cursor_changed(this);
+}
+
+int X11_SetSwapInterval(SDL_VideoDevice *this, int interval)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+
+	TRACE();
+
+	/* Only composited modes present through EGL */
+	if (!this->screen || !this->screen->hwdata) {
+		SDL_SetError("Swap interval needs a composited video mode");
+		return -1;
 	}
 
-	set_finish_hwdata(dsthwdata, dsthwdata);
+	/* Applied by whoever owns the context on the next present */
+	hidden->gl.swap_interval = interval;
 
-	if (dst == this->screen)
-		hidden->gl.dirty = 1;
+	return 0;
+}
 
-	if (glGetError())
-		ERROR();
+int X11_GetPresentStats(SDL_VideoDevice *this, SDL_PresentStats *stats)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct present_state *present = hidden->gl.present;
 
 	TRACE();
 
+	if (!this->screen || !this->screen->hwdata) {
+		SDL_SetError("No composited video mode");
+		return -1;
+	}
+
+	if (present)
+		SDL_mutexP(present->lock);
+	*stats = hidden->gl.stats;
+	if (present)
+		SDL_mutexV(present->lock);
+
 	return 0;
 }
 
@@ -1149,70 +3073,285 @@ static inline void clamp(Sint16* val, int min, int size)
 	}
 }
 
+/*
+ * Where the screen goes on the display, with the matching filters and
+ * input transform. Done once per mode instead of per frame and event.
+ */
+static void setup_view(SDL_VideoDevice *this, SDL_Surface *screen)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	int sw = screen->w, sh = screen->h;
+	int dw = DisplayWidth(SDL_Display, SDL_Screen);
+	int dh = DisplayHeight(SDL_Display, SDL_Screen);
+	int mode = SCALE_ASPECT;
+	int w, h, k;
+	const char *env;
+
+	env = SDL_getenv("SDL_VIDEO_X11_EGL_SCALE");
+	if (env) {
+		if (SDL_strcasecmp(env, "integer") == 0)
+			mode = SCALE_INTEGER;
+		else if (SDL_strcasecmp(env, "stretch") == 0)
+			mode = SCALE_STRETCH;
+		else if (SDL_strcasecmp(env, "sharp") == 0)
+			mode = SCALE_SHARP;
+	}
+
+	/* Too large for a whole multiple, shrink it like aspect does */
+	k = SDL_min(dw / sw, dh / sh);
+	if (mode == SCALE_INTEGER && k < 1)
+		mode = SCALE_ASPECT;
+
+	switch (mode) {
+	case SCALE_INTEGER:
+		w = sw * k;
+		h = sh * k;
+		break;
+	case SCALE_STRETCH:
+		w = dw;
+		h = dh;
+		break;
+	default:
+		/* Compare sw/sh against dw/dh without rounding */
+		if (sw * dh >= dw * sh) {
+			w = dw;
+			h = dw * sh / sw;
+		} else {
+			w = dh * sw / sh;
+			h = dh;
+		}
+		break;
+	}
+
+	hidden->gl.view.mode = mode;
+	hidden->gl.view.src_w = sw;
+	hidden->gl.view.src_h = sh;
+	hidden->gl.view.disp_w = dw;
+	hidden->gl.view.disp_h = dh;
+	hidden->gl.view.x = (dw - w) / 2;
+	hidden->gl.view.y = (dh - h) / 2;
+	hidden->gl.view.w = w;
+	hidden->gl.view.h = h;
+	hidden->gl.view.ndc_w = (float) w / dw;
+	hidden->gl.view.ndc_h = (float) h / dh;
+	hidden->gl.view.in_x = ((Uint32) sw << 16) / w;
+	hidden->gl.view.in_y = ((Uint32) sh << 16) / h;
+
+	if (mode == SCALE_INTEGER) {
+		hidden->gl.view.min_filter = GL_NEAREST;
+		hidden->gl.view.mag_filter = GL_NEAREST;
+	} else if (mode == SCALE_SHARP) {
+		hidden->gl.view.min_filter = GL_LINEAR;
+		hidden->gl.view.mag_filter = GL_LINEAR;
+	} else {
+		hidden->gl.view.min_filter = sw > w || sh > h ? GL_LINEAR : GL_NEAREST;
+		hidden->gl.view.mag_filter = sw < w || sh < h ? GL_LINEAR : GL_NEAREST;
+	}
+
+	DPRINTF("%p:%dx%d+0+0 -> %dx%d+%d+%d mode %d\n", screen, sw, sh,
+		w, h, hidden->gl.view.x, hidden->gl.view.y, mode);
+}
+
+/* The sharp program needs the source size and the whole scale factor */
+static int setup_sharp(SDL_VideoDevice *this, SDL_Surface *screen)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	GLuint prog;
+	int sx, sy;
+
+	if (hidden->gl.view.mode != SCALE_SHARP ||
+	    screen->format->BitsPerPixel == 8)
+		return 0;
+
+	if (compile_sharp_shaders(hidden))
+		return -1;
+	prog = hidden->gl.prog_sharp;
+
+	sx = SDL_max(hidden->gl.view.w / screen->w, 1);
+	sy = SDL_max(hidden->gl.view.h / screen->h, 1);
+
+	glUseProgram(prog);
+	glUniform1i(glGetUniformLocation(prog, "tex"), 0);
+	glUniform2f(glGetUniformLocation(prog, "tex_size"), screen->w, screen->h);
+	glUniform2f(glGetUniformLocation(prog, "prescale"), sx, sy);
+
+	return 0;
+}
+
 void X11_ScaleInput(SDL_VideoDevice *this, Sint16 *x, Sint16 *y)
 {
+	struct SDL_PrivateVideoData *hidden;
 	SDL_Surface *screen;
 
 	if (!this || !this->screen)
 		return;
 
+	hidden = this->hidden;
 	screen = this->screen;
 
-	int dw = DisplayWidth(SDL_Display, SDL_Screen);
-	int dh = DisplayHeight(SDL_Display, SDL_Screen);
-	GLfloat srcaspect = (GLfloat) screen->w / screen->h;
-	GLfloat dstaspect = (GLfloat) dw / dh;
-	int _x, _y, _w, _h;
-
-	if (srcaspect >= dstaspect) {
-		_w = dw;
-		_h = dw / srcaspect;
-	} else {
-		_w = dh * srcaspect;
-		_h = dh;
-	}
-	_x = (dw - _w) / 2;
-	_y = (dh - _h) / 2;
+	/* GL modes never went through setup_screen() */
+	if (hidden->gl.view.src_w != screen->w ||
+	    hidden->gl.view.src_h != screen->h)
+		setup_view(this, screen);
 
-	clamp(x, _x, _w);
-	clamp(y, _y, _h);
+	clamp(x, hidden->gl.view.x, hidden->gl.view.w);
+	clamp(y, hidden->gl.view.y, hidden->gl.view.h);
 
 	if (*x >= 0)
-		*x = *x * screen->w / _w;
+		*x = (*x * hidden->gl.view.in_x) >> 16;
 	if (*y >= 0)
-		*y = *y * screen->h / _h;
+		*y = (*y * hidden->gl.view.in_y) >> 16;
 }
 
-static void X11_UpdateRects(SDL_VideoDevice *this, int numrects, SDL_Rect *rects)
+/* The transform X11_ScaleInput() applies, for callers that fold it into
+   their own: the surface area on the display and 16.16 scale factors */
+void X11_GetInputView(SDL_VideoDevice *this, int *x, int *y, int *w, int *h,
+		      Uint32 *scale_x, Uint32 *scale_y)
 {
 	struct SDL_PrivateVideoData *hidden = this->hidden;
 	SDL_Surface *screen = this->screen;
-	struct private_hwdata *hwdata = screen->hwdata;
-	int dw = DisplayWidth(SDL_Display, SDL_Screen);
-	int dh = DisplayHeight(SDL_Display, SDL_Screen);
-	GLfloat srcaspect = (GLfloat) screen->w / screen->h;
-	GLfloat dstaspect = (GLfloat) dw / dh;
-	GLfloat w, h;
-
-	TRACE();
 
-	if (!hwdata)
+	if (!screen) {
+		*x = *y = 0;
+		*w = *h = 0x7fff;
+		*scale_x = *scale_y = 0x10000;
 		return;
+	}
 
-	if (screen->locked)
-		return; /* oops, what now? */
+	if (hidden->gl.view.src_w != screen->w ||
+	    hidden->gl.view.src_h != screen->h)
+		setup_view(this, screen);
 
-	if (!hidden->gl.dirty)
+	*x = hidden->gl.view.x;
+	*y = hidden->gl.view.y;
+	*w = hidden->gl.view.w;
+	*h = hidden->gl.view.h;
+	*scale_x = hidden->gl.view.in_x;
+	*scale_y = hidden->gl.view.in_y;
+}
+
+/* Latch the palette; the present thread may race with SetColors */
+static void upload_palette(SDL_VideoDevice *this)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct present_state *present = hidden->gl.present;
+	Uint8 palette[256 * 4];
+	int dirty;
+
+	if (present)
+		SDL_mutexP(present->lock);
+	dirty = hidden->gl.palette_dirty;
+	if (dirty)
+		SDL_memcpy(palette, hidden->gl.palette, sizeof palette);
+	hidden->gl.palette_dirty = 0;
+	if (present)
+		SDL_mutexV(present->lock);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, hidden->gl.palette_tex);
+	if (dirty)
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1,
+				GL_RGBA, GL_UNSIGNED_BYTE, palette);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/* The cursor quad goes on top, in the same letterboxed space as the screen */
+static void draw_cursor(SDL_VideoDevice *this, SDL_Surface *screen, GLfloat w, GLfloat h)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct present_state *present = hidden->gl.present;
+	const struct rgba_color color = { 1.0f, 1.0f, 1.0f, 1.0f };
+	GLfloat x1, y1, x2, y2;
+	int visible;
+
+	bind_texture(hidden, NULL);
+
+	if (present)
+		SDL_mutexP(present->lock);
+	visible = hidden->gl.cursor_image != NULL;
+	if (visible) {
+		if (!hidden->gl.cursor_tex) {
+			glGenTextures(1, &hidden->gl.cursor_tex);
+			glBindTexture(GL_TEXTURE_2D, hidden->gl.cursor_tex);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			hidden->gl.cursor_dirty = 1;
+		} else
+			glBindTexture(GL_TEXTURE_2D, hidden->gl.cursor_tex);
+
+		if (hidden->gl.cursor_dirty) {
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+				     hidden->gl.cursor_w, hidden->gl.cursor_h, 0,
+				     GL_RGBA, GL_UNSIGNED_BYTE, hidden->gl.cursor_image);
+			hidden->gl.cursor_dirty = 0;
+		}
+
+		x1 = hidden->gl.cursor_x - hidden->gl.cursor_hot_x;
+		y1 = hidden->gl.cursor_y - hidden->gl.cursor_hot_y;
+		x2 = x1 + hidden->gl.cursor_w;
+		y2 = y1 + hidden->gl.cursor_h;
+	}
+	if (present)
+		SDL_mutexV(present->lock);
+
+	if (!visible)
 		return;
 
-	/* Scale to fullscreen but keep pixels square */
-	if (srcaspect >= dstaspect) {
-		w = 1.0f;
-		h = dstaspect / srcaspect;
-	} else {
-		w = srcaspect / dstaspect;
-		h = 1.0f;
+	/* Screen pixels to normalized device coordinates */
+	x1 = -w + 2.0f * w * x1 / screen->w;
+	x2 = -w + 2.0f * w * x2 / screen->w;
+	y1 = h - 2.0f * h * y1 / screen->h;
+	y2 = h - 2.0f * h * y2 / screen->h;
+
+	const GLfloat verts[] = {
+		x1, y1,
+		x1, y2,
+		x2, y1,
+		x2, y2,
+	};
+	const GLfloat texcoords[] = {
+		0.0f, 0.0f,
+		0.0f, 1.0f,
+		1.0f, 0.0f,
+		1.0f, 1.0f,
+	};
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	draw_quad(verts, texcoords, &color, hidden->gl.prog_blit);
+
+	glBlendFunc(GL_ONE, GL_ZERO);
+	glDisable(GL_BLEND);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/* Draw the screen texture into its view of the window and swap */
+static void composite_screen(SDL_VideoDevice *this, SDL_Surface *screen, Uint32 start)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	struct private_hwdata *hwdata = screen->hwdata;
+	GLfloat w = hidden->gl.view.ndc_w;
+	GLfloat h = hidden->gl.view.ndc_h;
+	int interval = hidden->gl.swap_interval;
+	GLuint prog = hidden->gl.prog_blit;
+	Uint32 swap;
+
+	TRACE();
+
+	/* Adaptive: stop waiting for vblank while frames are late */
+	if (interval < 0) {
+		const SDL_PresentStats *stats = &hidden->gl.stats;
+		interval = stats->frame_us > stats->refresh_us * 3 / 2 ? 0 : 1;
 	}
+	if (interval != hidden->gl.cur_interval) {
+		eglSwapInterval(hidden->egl.dpy, interval);
+		hidden->gl.cur_interval = interval;
+	}
+
 	const GLfloat verts[] = {
 		-w,  h,
 		-w, -h,
@@ -1227,36 +3366,105 @@ static void X11_UpdateRects(SDL_VideoDevice *this, int numrects, SDL_Rect *rects
 	};
 	const struct rgba_color color = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-	DPRINTF("%p:%dx%d+0+0 -> %dx%d+%d+%d\n", screen, screen->w, screen->h,
-		(int) (w * dw), (int) (h * dh), (int) ((1.0f - w) * dw / 2.0f), (int) ((1.0f - h) * dh / 2.0f));
-
-	if (glGetError())
-		ERROR();
-
 	bind_texture(hidden, hwdata);
 	bind_framebuffer(hidden, NULL);
 
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-			screen->w > dw || screen->h > dh ?
-			GL_LINEAR : GL_NEAREST);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-			screen->w < dw || screen->h < dh ?
-			GL_LINEAR : GL_NEAREST);
+	if (screen->format->BitsPerPixel == 8) {
+		/* Filtering indices would blend unrelated palette entries */
+		prog = hidden->gl.prog_pal;
+		upload_palette(this);
+
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glUseProgram(prog);
+		glUniform1i(glGetUniformLocation(prog, "tex"), 0);
+		glUniform1i(glGetUniformLocation(prog, "palette"), 1);
+	} else {
+		if (hidden->gl.view.mode == SCALE_SHARP && hidden->gl.prog_sharp)
+			prog = hidden->gl.prog_sharp;
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+				hidden->gl.view.min_filter);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+				hidden->gl.view.mag_filter);
+	}
 
-	glViewport(0, 0, dw, dh);
+	glViewport(0, 0, hidden->gl.view.disp_w, hidden->gl.view.disp_h);
 
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
 
-	draw_quad(verts, texcoords, &color, hidden->gl.prog_blit);
+	draw_quad(verts, texcoords, &color, prog);
 
+	draw_cursor(this, screen, w, h);
+
+	swap = now_us();
 	eglSwapBuffers(hidden->egl.dpy, hidden->egl.surface);
+	update_stats(this, interval, start, swap, now_us());
 
-	set_finish_hwdata(hwdata, &screen_hwdata);
-	hidden->gl.dirty = 0;
+	if (glGetError())
+		ERROR();
+
+	TRACE();
+}
+
+static void X11_UpdateRects(SDL_VideoDevice *this, int numrects, SDL_Rect *rects)
+{
+	struct SDL_PrivateVideoData *hidden = this->hidden;
+	SDL_Surface *screen = this->screen;
+	struct private_hwdata *hwdata = screen->hwdata;
+	Uint32 start;
+
+	TRACE();
+
+	if (!hwdata)
+		return;
+
+	if (screen->locked)
+		return; /* oops, what now? */
+
+	if (hidden->gl.upload) {
+		int i;
+
+		for (i = 0; i < numrects; i++) {
+			if (!rects[i].w || !rects[i].h)
+				continue;
+			if (rects[i].y < hwdata->dirty_y1)
+				hwdata->dirty_y1 = rects[i].y;
+			if (rects[i].y + rects[i].h > hwdata->dirty_y2)
+				hwdata->dirty_y2 = rects[i].y + rects[i].h;
+		}
+
+		if (hwdata->dirty_y1 < 0)
+			hwdata->dirty_y1 = 0;
+		if (hwdata->dirty_y2 > screen->h)
+			hwdata->dirty_y2 = screen->h;
+
+		if (hwdata->dirty_y1 < hwdata->dirty_y2)
+			hidden->gl.dirty = 1;
+	}
+
+	if (!hidden->gl.dirty)
+		return;
+
+	if (hidden->gl.present) {
+		present_queue(this, screen);
+		hidden->gl.dirty = 0;
+		return;
+	}
 
 	if (glGetError())
 		ERROR();
 
+	start = now_us();
+
+	if (hidden->gl.upload)
+		upload_hwdata(this, screen);
+
+	composite_screen(this, screen, start);
+
+	set_finish_hwdata(hwdata, &screen_hwdata);
+	hidden->gl.dirty = 0;
+
 	TRACE();
 }
@@ -24,10 +24,14 @@
 #include "SDL_x11video.h"
 
 extern int X11_ResizeImage(_THIS, SDL_Surface *screen, Uint32 flags);
+extern void X11_ReleaseImage(_THIS, SDL_Surface *screen);
+extern void X11_DestroyImage(_THIS, SDL_Surface *screen);
+extern int X11_CanCompositeImage(_THIS);
 
 extern int X11_AllocHWSurface(_THIS, SDL_Surface *surface);
 extern void X11_FreeHWSurface(_THIS, SDL_Surface *surface);
 extern int X11_LockHWSurface(_THIS, SDL_Surface *surface);
+extern int X11_LockHWSurfaceEx(_THIS, SDL_Surface *surface, Uint32 flags, const SDL_Rect *rect);
 extern void X11_UnlockHWSurface(_THIS, SDL_Surface *surface);
 extern int X11_FlipHWSurface(_THIS, SDL_Surface *surface);
 
@@ -38,6 +42,20 @@ extern int X11_CheckHWBlit(_THIS, SDL_Surface *src, SDL_Surface *dst);
 extern int X11_CheckHWFill(_THIS, SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
 extern int X11_FillHWRect(_THIS, SDL_Surface *dst, SDL_Rect *dstrect, Uint32 color);
 
+extern SDL_Overlay *X11_CreateImageYUVOverlay(_THIS, int width, int height, Uint32 format, SDL_Surface *display);
+
+extern int X11_SetImageColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors);
+
+extern int X11_SetImageCursor(_THIS, const Uint8 *image, int w, int h, int hot_x, int hot_y);
+extern void X11_MoveImageCursor(_THIS, int x, int y);
+
+extern int X11_SetSwapInterval(_THIS, int interval);
+extern int X11_GetPresentStats(_THIS, SDL_PresentStats *stats);
+
 extern void X11_DisableAutoRefresh(_THIS);
 extern void X11_EnableAutoRefresh(_THIS);
 extern void X11_RefreshDisplay(_THIS);
+
+extern void X11_ScaleInput(_THIS, Sint16 *x, Sint16 *y);
+extern void X11_GetInputView(_THIS, int *x, int *y, int *w, int *h,
+			     Uint32 *scale_x, Uint32 *scale_y);
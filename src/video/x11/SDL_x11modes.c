@@ -926,7 +926,10 @@ int X11_SupportedVisual(_THIS, SDL_PixelFormat *format)
 
 SDL_Rect **X11_ListModes(_THIS, SDL_PixelFormat *format, Uint32 flags)
 {
-    if ( X11_SupportedVisual(this, format) ) {
+    /* The compositor resolves 8bpp screens through a palette texture */
+    if ( X11_SupportedVisual(this, format) ||
+         ((format->BitsPerPixel == 8) && !(flags & (SDL_OPENGL|SDL_OPENGLES)) &&
+          X11_CanCompositeImage(this)) ) {
         if ( flags & SDL_FULLSCREEN ) {
             return(SDL_modelist);
         } else {
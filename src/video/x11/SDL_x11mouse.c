@@ -28,12 +28,17 @@
 #include "../../events/SDL_events_c.h"
 #include "../SDL_cursor_c.h"
 #include "SDL_x11dga_c.h"
+#include "SDL_x11image_c.h"
 #include "SDL_x11mouse_c.h"
 
 
 /* The implementation dependent data for the window manager cursor */
 struct WMcursor {
 	Cursor x_cursor;
+	/* RGBA version for the compositor */
+	Uint8 *image;
+	int w, h;
+	int hot_x, hot_y;
 };
 
 
@@ -45,6 +50,7 @@ void X11_FreeWMCursor(_THIS, WMcursor *cursor)
 		XSync(SDL_Display, False);
 		SDL_Unlock_EventThread();
 	}
+	SDL_free(cursor->image);
 	SDL_free(cursor);
 }
 
@@ -92,6 +98,25 @@ WMcursor *X11_CreateWMCursor(_THIS,
 		x_data[i] = data[i];
 	}
 
+	/* Expand the same black/white/transparent image for the compositor */
+	cursor->image = (Uint8 *)SDL_malloc(w*h*4);
+	if ( cursor->image != NULL ) {
+		Uint8 *dst = cursor->image;
+
+		for ( i=0; i<w*h; ++i ) {
+			Uint8 bit = 0x80 >> (i%8);
+			Uint8 color = (x_data[i/8] & bit) ? 0x00 : 0xFF;
+
+			dst[0] = dst[1] = dst[2] = color;
+			dst[3] = (x_mask[i/8] & bit) ? 0xFF : 0x00;
+			dst += 4;
+		}
+	}
+	cursor->w = w;
+	cursor->h = h;
+	cursor->hot_x = hot_x;
+	cursor->hot_y = hot_y;
+
 	/* Prevent the event thread from running while we use the X server */
 	SDL_Lock_EventThread();
 
@@ -150,6 +175,15 @@ int X11_ShowWMCursor(_THIS, WMcursor *cursor)
 		return(0);
 	}
 
+	/* The compositor draws the cursor itself, keep the X11 one blank */
+	if ( cursor == NULL ) {
+		X11_SetImageCursor(this, NULL, 0, 0, 0, 0);
+	} else if ( cursor->image != NULL &&
+	            X11_SetImageCursor(this, cursor->image, cursor->w,
+	                               cursor->h, cursor->hot_x, cursor->hot_y) ) {
+		cursor = NULL;
+	}
+
 	/* Set the X11 cursor cursor, or blank if cursor is NULL */
 	if ( SDL_Window ) {
 		SDL_Lock_EventThread();
@@ -184,6 +218,12 @@ void X11_WarpWMCursor(_THIS, Uint16 x, Uint16 y)
 	}
 }
 
+void X11_MoveWMCursor(_THIS, int x, int y)
+{
+	/* The X server moves its own cursor, only the composited one follows */
+	X11_MoveImageCursor(this, x, y);
+}
+
 /* Sets the mouse acceleration from a string of the form:
 	2/1/0
    The first number is the numerator, followed by the acceleration
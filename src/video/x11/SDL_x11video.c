@@ -24,8 +24,9 @@
 /* X11 based SDL video driver implementation.
    Note:  This implementation does not currently need X11 thread locking,
           since the event thread uses a separate X connection and any
-          additional locking necessary is handled internally.  However,
-          if full locking is neccessary, take a look at XInitThreads().
+          additional locking necessary is handled internally.  The
+          exception is the asynchronous EGL present thread, which swaps
+          on SDL_Display: XInitThreads() is called when it is enabled.
 */
 
 #include <unistd.h>
@@ -78,10 +79,23 @@ static void X11_VideoQuit(_THIS);
 
 /* X11 driver bootstrap functions */
 
+/* The asynchronous present thread swaps buffers on SDL_Display while
+   events are pumped from another thread, so Xlib has to lock it.  This
+   must happen before the first connection is opened. */
+static void X11_InitThreads(void)
+{
+	const char *env = SDL_getenv("SDL_VIDEO_X11_EGL_ASYNC");
+
+	if ( env && SDL_atoi(env) > 0 ) {
+		XInitThreads();
+	}
+}
+
 static int X11_Available(void)
 {
 	Display *display = NULL;
 	if ( SDL_X11_LoadSymbols() ) {
+		X11_InitThreads();
 		display = XOpenDisplay(NULL);
 		if ( display != NULL ) {
 			XCloseDisplay(display);
@@ -137,9 +151,11 @@ static SDL_VideoDevice *X11_CreateDevice(int devindex)
 #if SDL_VIDEO_OPENGL_GLX
 		device->gl_data->swap_interval = -1;
 #endif
+		device->hidden->gl.swap_interval = 1;
 
 		/* Set the driver flags */
 		device->handles_any_size = 1;
+		device->stretch_blit = 1;
 
 		/* Set the function pointers */
 		device->VideoInit = X11_VideoInit;
@@ -147,9 +163,7 @@ static SDL_VideoDevice *X11_CreateDevice(int devindex)
 		device->SetVideoMode = X11_SetVideoMode;
 		device->ToggleFullScreen = X11_ToggleFullScreen;
 		device->UpdateMouse = X11_UpdateMouse;
-#if SDL_VIDEO_DRIVER_X11_XV
-		device->CreateYUVOverlay = X11_CreateYUVOverlay;
-#endif
+		device->CreateYUVOverlay = X11_CreateImageYUVOverlay;
 		device->SetColors = X11_SetColors;
 		device->UpdateRects = NULL;
 		device->VideoQuit = X11_VideoQuit;
@@ -161,8 +175,11 @@ static SDL_VideoDevice *X11_CreateDevice(int devindex)
 		device->SetHWAlpha = X11_SetHWAlpha;
 		device->LockHWSurface = X11_LockHWSurface;
 		device->UnlockHWSurface = X11_UnlockHWSurface;
+		device->LockHWSurfaceEx = X11_LockHWSurfaceEx;
 		device->FlipHWSurface = X11_FlipHWSurface;
 		device->FreeHWSurface = X11_FreeHWSurface;
+		device->SetSwapInterval = X11_SetSwapInterval;
+		device->GetPresentStats = X11_GetPresentStats;
 		device->SetGamma = X11_SetVidModeGamma;
 		device->GetGamma = X11_GetVidModeGamma;
 		device->SetGammaRamp = X11_SetGammaRamp;
@@ -190,6 +207,7 @@ static SDL_VideoDevice *X11_CreateDevice(int devindex)
 		device->CreateWMCursor = X11_CreateWMCursor;
 		device->ShowWMCursor = X11_ShowWMCursor;
 		device->WarpWMCursor = X11_WarpWMCursor;
+		device->MoveWMCursor = X11_MoveWMCursor;
 		device->CheckMouseMode = X11_CheckMouseMode;
 		device->InitOSKeymap = X11_InitOSKeymap;
 		device->PumpEvents = X11_PumpEvents;
@@ -571,6 +589,7 @@ static int X11_VideoInit(_THIS, SDL_PixelFormat *vformat)
 	} else {
 		local_X11 = 0;
 	}
+	X11_InitThreads();
 	SDL_Display = XOpenDisplay(display);
 #if defined(__osf__) && defined(SDL_VIDEO_DRIVER_X11_DYNAMIC)
 	/* On Tru64 if linking without -lX11, it fails and you get following message.
@@ -726,6 +745,10 @@ static int X11_VideoInit(_THIS, SDL_PixelFormat *vformat)
 #endif
 	}
 
+	/* Only the last of consecutive motion events is seen if requested */
+	env = SDL_getenv("SDL_VIDEO_X11_COMPRESS_MOTION");
+	compress_motion = env ? SDL_atoi(env) : 0;
+
 	/* See if we have been passed a window to use */
 	SDL_windowid = SDL_getenv("SDL_WINDOWID");
 
@@ -942,11 +965,12 @@ static int X11_CreateWindow(_THIS, SDL_Surface *screen,
 	int i, depth;
 	Visual *vis;
 	int vis_change;
+	int palette_emul = 0;
 	Uint32 Amask;
 
 	/* If a window is already present, destroy it and start fresh */
 	if ( SDL_Window ) {
-		X11_DestroyImage(this, screen);
+		X11_ReleaseImage(this, screen);
 		X11_DestroyWindow(this, screen);
 	}
 
@@ -987,6 +1011,19 @@ static int X11_CreateWindow(_THIS, SDL_Surface *screen,
 			if ( this->hidden->visuals[i].bpp == bpp )
 				break;
 		}
+		if ( (i == this->hidden->nvisuals) && (bpp == 8) &&
+		     X11_CanCompositeImage(this) ) {
+			/* Emulated by the compositor, any visual will do */
+			for ( i = 0; i < this->hidden->nvisuals; i++ ) {
+				if ( this->hidden->visuals[i].depth ==
+				     DefaultDepth(SDL_Display, SDL_Screen) )
+					break;
+			}
+			if ( i == this->hidden->nvisuals ) {
+				i = 0;
+			}
+			palette_emul = 1;
+		}
 		if ( i == this->hidden->nvisuals ) {
 			SDL_SetError("No matching visual for requested depth");
 			return -1;	/* should never happen */
@@ -1007,7 +1044,12 @@ static int X11_CreateWindow(_THIS, SDL_Surface *screen,
 	} else {
 		Amask = 0;
 	}
-	if ( ! SDL_ReallocFormat(screen, bpp,
+	if ( palette_emul ) {
+		if ( ! SDL_ReallocFormat(screen, bpp, 0, 0, 0, 0) ) {
+			return -1;
+		}
+		screen->flags |= SDL_HWPALETTE;
+	} else if ( ! SDL_ReallocFormat(screen, bpp,
 			vis->red_mask, vis->green_mask, vis->blue_mask, Amask) ) {
 		return -1;
 	}
@@ -1314,6 +1356,11 @@ SDL_Surface *X11_SetVideoMode(_THIS, SDL_Surface *current,
 	current->flags |= (flags&(SDL_RESIZABLE|SDL_NOFRAME));
 
   done:
+#if SDL_VIDEO_DRIVER_X11_XINPUT2
+	/* Touch positions are mapped for the old window and mode */
+	xi_touch.valid = 0;
+#endif
+
 	/* Release the event thread */
 	XSync(SDL_Display, False);
 	SDL_Unlock_EventThread();
@@ -1455,6 +1502,12 @@ int X11_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 {
 	int nrej = 0;
 
+	/* Palette emulated by the compositor */
+	if ( (this->screen->format->BitsPerPixel == 8) &&
+	     (SDL_Visual->class != PseudoColor) ) {
+		return X11_SetImageColors(this, firstcolor, ncolors, colors);
+	}
+
 	/* Check to make sure we have a colormap allocated */
 	if ( SDL_XPixels == NULL ) {
 		return(0);
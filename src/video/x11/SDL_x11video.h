@@ -140,6 +140,24 @@ struct SDL_PrivateVideoData {
     int xi_opcode;
     XIDeviceInfo *xi_master;
     int have_touch;
+
+    /* Touch contacts of the master pointer and their mapping to the
+       surface, rebuilt when the device, window or mode changes */
+    struct {
+	int count;
+	struct {
+	    int x, y, id, pressure;	/* valuator numbers */
+	    int min_x, min_y, min_pressure;
+	    int range_x, range_y, range_pressure;
+	    Uint32 scale_x, scale_y;	/* 16.16 device to display pixels */
+	} contact[16];
+	struct {
+	    int origin;			/* display pixel of the surface origin */
+	    int lo, hi;			/* visible part, from the origin */
+	    Uint32 scale;		/* 16.16 display to surface pixels */
+	} axis[2];
+	int valid;			/* cleared when the device, window or mode changes */
+    } xi_touch;
 #endif
 #if SDL_VIDEO_DRIVER_X11_VIDMODE
     SDL_NAME(XF86VidModeModeInfo) saved_mode;
@@ -172,18 +190,60 @@ struct SDL_PrivateVideoData {
     /* Screensaver settings */
     int allow_screensaver;
 
+    /* Flag: merge consecutive pointer motion before dispatch */
+    int compress_motion;
+
 	struct {
 		EGLDisplay dpy;
 		EGLContext ctx;
 		EGLSurface surface;
+		int unusable;	/* EGL or GLES2 failed to initialize */
+		unsigned int serial;	/* bumped for every new context */
 	} egl;
 	struct {
 		GLuint prog_fill;
 		GLuint prog_blit;
 		GLuint prog_ckey;
+		GLuint prog_yuv;
+		GLuint prog_nv12;
+		GLuint prog_pal;
+		GLuint prog_sharp;
+		GLuint palette_tex;	/* 256x1 RGBA lookup for 8bpp screens */
+		Uint8 palette[256 * 4];
+		int palette_dirty;
+		Uint8 *cursor_image;	/* RGBA, drawn over the screen */
+		int cursor_w, cursor_h;
+		int cursor_hot_x, cursor_hot_y;
+		int cursor_x, cursor_y;
+		int cursor_dirty;	/* image changed since the last upload */
+		GLuint cursor_tex;
+		char *cache_dir;	/* program binary cache, NULL if disabled */
+		Uint64 cache_key;	/* hash of the driver identification */
+		int cache_hits;
 		void *tex_hwdata;
 		void *fbo_hwdata;
 		int dirty;
+		int upload;	/* no lock_surface/EGLImage, stream with glTexSubImage2D */
+		int upload_required;	/* upload for every mode, not just 8bpp */
+		int screen_bpp;	/* the mode the screen image was made for */
+		Uint32 screen_flags;
+		void *present;	/* asynchronous present thread state */
+		void *atlas;	/* pages shared by small HW surfaces */
+		int use_atlas;
+		struct {
+			int mode;	/* SDL_VIDEO_X11_EGL_SCALE */
+			int src_w, src_h;	/* screen size this was set up for */
+			int disp_w, disp_h;
+			int x, y, w, h;	/* screen area on the display */
+			float ndc_w, ndc_h;	/* the same as half extents in clip space */
+			GLenum min_filter, mag_filter;
+			Uint32 in_x, in_y;	/* display to screen pixels, 16.16 */
+		} view;
+		int swap_interval;	/* requested, -1 for adaptive */
+		int cur_interval;	/* last value given to eglSwapInterval() */
+		Uint32 last_present_us;
+		int stats_dump;	/* print stats every this many frames */
+		SDL_PresentStats stats;
 	} gl;
 };
 
@@ -224,6 +284,7 @@ struct SDL_PrivateVideoData {
 #define xi_opcode			(this->hidden->xi_opcode)
 #define xi_master			(this->hidden->xi_master)
 #define have_touch			(this->hidden->have_touch)
+#define xi_touch			(this->hidden->xi_touch)
 #define use_xinerama		(this->hidden->use_xinerama)
 #define use_vidmode		(this->hidden->use_vidmode)
 #define use_xrandr		(this->hidden->use_xrandr)
@@ -238,6 +299,7 @@ struct SDL_PrivateVideoData {
 #define gamma_changed		(this->hidden->gamma_changed)
 #define SDL_iconcolors		(this->hidden->iconcolors)
 #define allow_screensaver	(this->hidden->allow_screensaver)
+#define compress_motion		(this->hidden->compress_motion)
 
 #define atom(i)             (this->hidden->atoms[i])
 
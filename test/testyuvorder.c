@@ -0,0 +1,132 @@
+
+/* Check that YV12 and IYUV overlays of the same picture look the same.
+   The two formats only differ in the order of the U and V planes, so
+   a driver mixing them up shows a swapped picture for one of them.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "SDL.h"
+
+#define PIC_W	64
+#define PIC_H	64
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+	SDL_Quit();
+	exit(rc);
+}
+
+/* Luma ramps across, U across and V down, so a swap can't go unnoticed */
+static void fill_overlay(SDL_Overlay *overlay)
+{
+	Uint8 *y, *u, *v;
+	int i, j;
+
+	if ( overlay->format == SDL_YV12_OVERLAY ) {
+		v = overlay->pixels[1];
+		u = overlay->pixels[2];
+	} else {
+		u = overlay->pixels[1];
+		v = overlay->pixels[2];
+	}
+	y = overlay->pixels[0];
+
+	for ( j = 0; j < PIC_H; j++ ) {
+		for ( i = 0; i < PIC_W; i++ ) {
+			y[j * overlay->pitches[0] + i] = 32 + i * 3;
+		}
+	}
+	for ( j = 0; j < PIC_H / 2; j++ ) {
+		for ( i = 0; i < PIC_W / 2; i++ ) {
+			u[j * overlay->pitches[1] + i] = 64 + i * 4;
+			v[j * overlay->pitches[2] + i] = 192 - j * 4;
+		}
+	}
+}
+
+static SDL_Overlay *show_overlay(SDL_Surface *screen, Uint32 format, int x)
+{
+	SDL_Overlay *overlay;
+	SDL_Rect rect;
+
+	overlay = SDL_CreateYUVOverlay(PIC_W, PIC_H, format, screen);
+	if ( overlay == NULL ) {
+		fprintf(stderr, "Couldn't create overlay: %s\n", SDL_GetError());
+		quit(1);
+	}
+	printf("Created %dx%dx%d %s %s overlay\n", overlay->w, overlay->h,
+	       overlay->planes, overlay->hw_overlay ? "hardware" : "software",
+	       format == SDL_YV12_OVERLAY ? "YV12" : "IYUV");
+
+	SDL_LockYUVOverlay(overlay);
+	fill_overlay(overlay);
+	SDL_UnlockYUVOverlay(overlay);
+
+	rect.x = x;
+	rect.y = 0;
+	rect.w = PIC_W;
+	rect.h = PIC_H;
+	if ( SDL_DisplayYUVOverlay(overlay, &rect) < 0 ) {
+		fprintf(stderr, "Couldn't display overlay: %s\n", SDL_GetError());
+		quit(1);
+	}
+	return overlay;
+}
+
+int main(int argc, char *argv[])
+{
+	SDL_Surface *screen;
+	SDL_Overlay *yv12, *iyuv;
+	Uint8 *row, *a, *b;
+	int bpp, x, y, k, bad;
+
+	if ( SDL_Init(SDL_INIT_VIDEO) < 0 ) {
+		fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return(1);
+	}
+
+	screen = SDL_SetVideoMode(PIC_W * 2, PIC_H, 32, SDL_SWSURFACE);
+	if ( screen == NULL ) {
+		fprintf(stderr, "Couldn't set video mode: %s\n", SDL_GetError());
+		quit(1);
+	}
+
+	yv12 = show_overlay(screen, SDL_YV12_OVERLAY, 0);
+	iyuv = show_overlay(screen, SDL_IYUV_OVERLAY, PIC_W);
+
+	/* Both halves went through the same conversion, so allow no slack */
+	bad = 0;
+	bpp = screen->format->BytesPerPixel;
+	if ( SDL_LockSurface(screen) < 0 ) {
+		fprintf(stderr, "Couldn't lock the screen: %s\n", SDL_GetError());
+		quit(1);
+	}
+	for ( y = 0; y < PIC_H; y++ ) {
+		row = (Uint8 *)screen->pixels + y * screen->pitch;
+		for ( x = 0; x < PIC_W; x++ ) {
+			a = row + x * bpp;
+			b = row + (PIC_W + x) * bpp;
+			for ( k = 0; k < bpp; k++ ) {
+				if ( a[k] != b[k] ) {
+					bad++;
+					break;
+				}
+			}
+		}
+	}
+	SDL_UnlockSurface(screen);
+
+	SDL_FreeYUVOverlay(yv12);
+	SDL_FreeYUVOverlay(iyuv);
+
+	if ( bad ) {
+		printf("YV12 and IYUV differ in %d of %d pixels\n", bad, PIC_W * PIC_H);
+		quit(1);
+	}
+	printf("YV12 and IYUV overlays match\n");
+	quit(0);
+	return(0);
+}